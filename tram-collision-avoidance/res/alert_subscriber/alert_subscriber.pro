@@ -0,0 +1,8 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp
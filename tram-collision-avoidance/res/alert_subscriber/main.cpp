@@ -0,0 +1,96 @@
+//
+// Configuration
+//
+
+// Includes
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "alertmessage.h"
+
+// Names, in order of HazardType
+static const char* gHazardNames[] = { "tram", "pedestrian", "vehicle" };
+
+
+//
+// Main
+//
+
+// Print the alerts published on a socket, as the warning unit would see
+// them, along with how long they took to arrive:
+//   alert_subscriber PATH
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s PATH\n", argv[0]);
+        return 1;
+    }
+
+    sockaddr_un tAddress;
+    memset(&tAddress, 0, sizeof(tAddress));
+    tAddress.sun_family = AF_UNIX;
+    strncpy(tAddress.sun_path, argv[1], sizeof(tAddress.sun_path) - 1);
+    int tSocket = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (tSocket < 0 || connect(tSocket, (sockaddr*) &tAddress, sizeof(tAddress)) != 0)
+    {
+        fprintf(stderr, "could not connect to %s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    AlertMessage tMessage;
+    bool tFirst = true;
+    uint32_t tExpected = 0;
+    for (;;)
+    {
+        ssize_t tSize = recv(tSocket, &tMessage, sizeof(tMessage), 0);
+        if (tSize == 0)
+            break;
+        if (tSize < 0)
+        {
+            fprintf(stderr, "could not receive: %s\n", strerror(errno));
+            return 1;
+        }
+        timespec tNow;
+        clock_gettime(CLOCK_MONOTONIC, &tNow);
+        uint64_t tReceived = (uint64_t) tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000;
+
+        if (tSize != sizeof(tMessage) || tMessage.magic != ALERT_MAGIC || tMessage.version != ALERT_VERSION || tMessage.size != sizeof(tMessage))
+        {
+            fprintf(stderr, "skipping a message of %d bytes which doesn't match this version\n", (int) tSize);
+            continue;
+        }
+        if (!tFirst && tMessage.sequence != tExpected)
+            printf("(%u messages missed)\n", tMessage.sequence - tExpected);
+        tFirst = false;
+        tExpected = tMessage.sequence + 1;
+
+        printf("stream %u frame %llu at %.0f ms, latency %llu us",
+               tMessage.stream, (unsigned long long) tMessage.frame, tMessage.timestamp,
+               (unsigned long long) (tReceived - tMessage.sent));
+        if (tMessage.flags & ALERT_TRAM_VALID)
+            printf(", tram at %.1f m", tMessage.tramDistance);
+        if (tMessage.flags & ALERT_TTC_VALID)
+            printf(", collision in %.1f s", tMessage.timeToCollision);
+        if (tMessage.flags & ALERT_TRACKS_VALID)
+            printf(", rails of %d and %d points", tMessage.leftPoints, tMessage.rightPoints);
+        printf("\n");
+
+        for (int i = 0; i < tMessage.hazards && i < ALERT_MAX_HAZARDS; i++)
+        {
+            const AlertHazard& tHazard = tMessage.hazard[i];
+            printf("  %s %u %s at (%d, %d) %dx%d, %.1f m\n",
+                   tHazard.type < 3 ? gHazardNames[tHazard.type] : "unknown", tHazard.id,
+                   tHazard.inside ? "inside" : "near",
+                   tHazard.box.x, tHazard.box.y, tHazard.box.width, tHazard.box.height, tHazard.distance);
+        }
+        fflush(stdout);
+    }
+
+    close(tSocket);
+    return 0;
+}
@@ -0,0 +1,176 @@
+//
+// Configuration
+//
+
+// Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <string>
+#include "opencv/cv.h"
+#include "opencv/highgui.h"
+#include "sharedframes.h"
+
+// Producer properties
+#define PRODUCER_DEFAULT_SLOTS 4
+#define PRODUCER_DEFAULT_FPS 25
+
+
+//
+// Auxiliary
+//
+
+static uint64_t monotonic()
+{
+    timespec tNow;
+    clock_gettime(CLOCK_MONOTONIC, &tNow);
+    return (uint64_t) tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000;
+}
+
+static uint64_t align(uint64_t iValue)
+{
+    return (iValue + SHARED_FRAMES_ALIGN - 1) / SHARED_FRAMES_ALIGN * SHARED_FRAMES_ALIGN;
+}
+
+// Pick the slot to fill next: anything but the latest one, which the
+// consumer doesn't hold (-1 if it holds them all)
+static int pick(SharedFramesHeader* iHeader)
+{
+    uint32_t tLatest = __sync_fetch_and_add(&iHeader->latest, 0);
+    for (uint32_t i = 1; i < iHeader->slots; i++)
+    {
+        uint32_t tSlot = (tLatest + i) % iHeader->slots;
+        if (__sync_fetch_and_add(&iHeader->slot[tSlot].held, 0) == 0)
+            return tSlot;
+    }
+    return -1;
+}
+
+
+//
+// Main
+//
+
+// Decode a video file into a ring of frames in shared memory, at the pace
+// of its frame rate, as a reference for what a decoder feeding
+// "shm://NAME" has to do:
+//   shm_producer FILE NAME [SLOTS]
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 4)
+    {
+        fprintf(stderr, "usage: %s FILE NAME [SLOTS]\n", argv[0]);
+        return 1;
+    }
+    uint32_t tSlots = argc > 3 ? atoi(argv[3]) : PRODUCER_DEFAULT_SLOTS;
+    if (tSlots < 3 || tSlots > SHARED_FRAMES_MAX_SLOTS)
+    {
+        fprintf(stderr, "the ring needs between 3 and %d slots\n", SHARED_FRAMES_MAX_SLOTS);
+        return 1;
+    }
+
+    // The first frame tells the layout of the slots
+    cv::VideoCapture tCapture(argv[1]);
+    cv::Mat tFrame;
+    if (!tCapture.isOpened() || !tCapture.read(tFrame) || !tFrame.data)
+    {
+        fprintf(stderr, "could not decode %s\n", argv[1]);
+        return 1;
+    }
+    double tFps = tCapture.get(CV_CAP_PROP_FPS);
+    if (tFps <= 0 || tFps > 1000)
+        tFps = PRODUCER_DEFAULT_FPS;
+
+    uint64_t tOffset = align(sizeof(SharedFramesHeader));
+    uint64_t tSlotSize = align(tFrame.step[0] * tFrame.rows);
+    uint64_t tSize = tOffset + tSlots * tSlotSize;
+    std::string tName = std::string("/") + argv[2];
+    int tFile = shm_open(tName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (tFile < 0 || ftruncate(tFile, tSize) != 0)
+    {
+        fprintf(stderr, "could not create %s: %s\n", tName.c_str(), strerror(errno));
+        return 1;
+    }
+    void* tMemory = mmap(0, tSize, PROT_READ | PROT_WRITE, MAP_SHARED, tFile, 0);
+    close(tFile);
+    if (tMemory == MAP_FAILED)
+    {
+        fprintf(stderr, "could not map %s: %s\n", tName.c_str(), strerror(errno));
+        shm_unlink(tName.c_str());
+        return 1;
+    }
+
+    // Set up the header, and only then make it recognizable
+    SharedFramesHeader* tHeader = (SharedFramesHeader*) tMemory;
+    tHeader->version = SHARED_FRAMES_VERSION;
+    tHeader->slots = tSlots;
+    tHeader->width = tFrame.cols;
+    tHeader->height = tFrame.rows;
+    tHeader->type = tFrame.type();
+    tHeader->step = tFrame.step[0];
+    tHeader->slotSize = tSlotSize;
+    tHeader->dataOffset = tOffset;
+    tHeader->fps = tFps;
+    __sync_synchronize();
+    tHeader->magic = SHARED_FRAMES_MAGIC;
+    printf("writing %dx%d frames at %.1f fps into %s\n", tFrame.cols, tFrame.rows, tFps, tName.c_str());
+
+    uint64_t tStart = monotonic();
+    uint64_t tSequence = 0;
+    cv::Mat tDecoded = tFrame;
+    for (;;)
+    {
+        // Only decode the frame if there's a free slot for it, as the
+        // consumer might hold on to all of them
+        int tSlot = pick(tHeader);
+        if (tSequence > 0 && (!tCapture.grab() || (tSlot >= 0 && !tCapture.retrieve(tDecoded))))
+            break;
+
+        // The capture decodes into a buffer of its own, so copy the frame
+        // into the slot (unless the size of the frames changed)
+        bool tFits = tSlot >= 0 && tDecoded.data
+                     && tDecoded.cols == (int) tHeader->width && tDecoded.rows == (int) tHeader->height
+                     && tDecoded.type() == (int) tHeader->type;
+        if (tFits)
+        {
+            cv::Mat tTarget(tHeader->height, tHeader->width, tHeader->type, (uchar*) tMemory + tOffset + tSlot * tSlotSize, tHeader->step);
+            tDecoded.copyTo(tTarget);
+        }
+
+        // Pace the frames as a camera would deliver them
+        uint64_t tDue = tStart + (uint64_t) (tSequence * 1000000 / tFps);
+        uint64_t tNow = monotonic();
+        if (tDue > tNow)
+            usleep(tDue - tNow);
+
+        // Publish the slot once it's complete
+        if (tFits)
+        {
+            SharedFrameSlot& tInfo = tHeader->slot[tSlot];
+            tInfo.sequence = tSequence;
+            tInfo.position = tSequence * 1000 / tFps;
+            tInfo.written = monotonic();
+            __sync_synchronize();
+            tHeader->latest = tSlot;
+            tHeader->published = 1;
+            __sync_synchronize();
+        }
+        else
+            __sync_fetch_and_add(&tHeader->skipped, 1);
+        tSequence++;
+    }
+
+    // Frames already mapped by the consumer stay valid after unlinking
+    __sync_synchronize();
+    tHeader->closed = 1;
+    __sync_synchronize();
+    printf("wrote %llu frames, %u skipped\n", (unsigned long long) tSequence, tHeader->skipped);
+    munmap(tMemory, tSize);
+    shm_unlink(tName.c_str());
+    return 0;
+}
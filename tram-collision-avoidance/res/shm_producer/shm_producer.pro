@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += console link_pkgconfig
+CONFIG -= qt
+PKGCONFIG += opencv
+
+INCLUDEPATH += ../../src
+LIBS += -lrt
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,83 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef ALERTMESSAGE_H
+#define ALERTMESSAGE_H
+
+// Includes
+#include <stdint.h>
+
+// Message properties
+#define ALERT_MAGIC 0x544d5241      // "ARMT" in memory, on a little endian host
+#define ALERT_VERSION 1
+#define ALERT_MAX_HAZARDS 16
+#define ALERT_TRACK_POINTS 16       // per rail
+
+// Flags
+#define ALERT_TRAM_VALID 0x01       // the tram box and distance are set
+#define ALERT_TRACKS_VALID 0x02     // the rails are set
+#define ALERT_TTC_VALID 0x04        // closing in on the tram ahead
+
+/*
+  The AlertMessage is what the alert output sends for every processed
+  frame: the tram ahead, the hazards in or near the path of the tram (most
+  urgent first), and both rails as a polyline. Its layout is fixed, in host
+  byte order, and every field is naturally aligned, so a subscriber on the
+  same machine can use a received message as is. Consumers are expected to
+  check the magic, version and size before anything else.
+
+  This header doesn't depend on anything but the C library, so subscribers
+  can include it without pulling in Qt or OpenCV.
+  */
+
+// A box in the frame, in pixels
+struct AlertBox
+{
+    int16_t x, y, width, height;
+};
+
+struct AlertHazard
+{
+    uint32_t id;                // of the tracked object (0 for the tram)
+    uint8_t type;               // as HazardType
+    uint8_t inside;             // in the corridor, rather than next to it
+    uint16_t reserved;
+    AlertBox box;
+    float distance;             // in meters (0 if unknown)
+};
+
+struct AlertPoint
+{
+    int16_t x, y;
+};
+
+struct AlertMessage
+{
+    // Header
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;              // of the whole message, in bytes
+    uint32_t stream;            // index of the stream within the process
+    uint32_t sequence;          // per output, to detect lost messages
+    uint64_t frame;
+    double timestamp;           // position in the stream, in milliseconds
+    uint64_t sent;              // on the monotonic clock, in microseconds
+
+    // Tram ahead
+    uint32_t flags;
+    AlertBox tram;
+    float tramDistance;         // in meters
+    float closingSpeed;         // in meters per second
+    float timeToCollision;      // in seconds
+
+    // Counts of the arrays below
+    uint8_t hazards, leftPoints, rightPoints, reserved;
+
+    AlertHazard hazard[ALERT_MAX_HAZARDS];
+    AlertPoint left[ALERT_TRACK_POINTS], right[ALERT_TRACK_POINTS];
+    uint32_t padding;           // to a multiple of 8 bytes, as the compiler would
+};
+
+#endif // ALERTMESSAGE_H
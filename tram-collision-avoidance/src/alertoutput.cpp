@@ -0,0 +1,264 @@
+//
+// Configuration
+//
+
+// Includes
+#include "alertoutput.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <QMutexLocker>
+#include "logger.h"
+
+// Output properties
+#define ALERT_BACKLOG 4             // subscribers waiting to be accepted
+
+// The layout is shared with other processes, so it must not change by accident
+typedef char AlertMessageSize[sizeof(AlertMessage) == 520 ? 1 : -1];
+
+
+//
+// Construction and destruction
+//
+
+AlertOutput::AlertOutput() : mSocket(-1), mSequence(0), mDropped(0)
+{
+}
+
+AlertOutput::~AlertOutput()
+{
+    close();
+}
+
+
+//
+// Socket
+//
+
+// Listen for subscribers on a socket at the given path. A socket a previous
+// run left behind gets replaced, but anything else at that path is left
+// alone (and the output doesn't open).
+bool AlertOutput::open(const std::string& iPath)
+{
+    close();
+
+    sockaddr_un tAddress;
+    memset(&tAddress, 0, sizeof(tAddress));
+    tAddress.sun_family = AF_UNIX;
+    if (iPath.size() >= sizeof(tAddress.sun_path))
+    {
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "alert socket path {} is too long", iPath);
+        return false;
+    }
+    strcpy(tAddress.sun_path, iPath.c_str());
+
+    int tSocket = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (tSocket < 0)
+    {
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not create the alert socket: {}", std::string(strerror(errno)));
+        return false;
+    }
+    struct stat tStat;
+    if (lstat(iPath.c_str(), &tStat) == 0)
+    {
+        if (!S_ISSOCK(tStat.st_mode))
+        {
+            Logger::instance().log(LOG_ERROR, LOG_SERVER, "{} exists and is not a socket, not replacing it", iPath);
+            ::close(tSocket);
+            return false;
+        }
+        unlink(iPath.c_str());
+    }
+    if (bind(tSocket, (sockaddr*) &tAddress, sizeof(tAddress)) != 0 || listen(tSocket, ALERT_BACKLOG) != 0)
+    {
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not listen on {}: {}", iPath, std::string(strerror(errno)));
+        ::close(tSocket);
+        return false;
+    }
+
+    // Subscribers get accepted while publishing, which mustn't wait for them
+    fcntl(tSocket, F_SETFL, fcntl(tSocket, F_GETFL) | O_NONBLOCK);
+
+    QMutexLocker tLocker(&mMutex);
+    mPath = iPath;
+    mSocket = tSocket;
+    Logger::instance().log(LOG_INFO, LOG_SERVER, "publishing alerts on {}", iPath);
+    return true;
+}
+
+void AlertOutput::close()
+{
+    QMutexLocker tLocker(&mMutex);
+    for (size_t i = 0; i < mSubscribers.size(); i++)
+        ::close(mSubscribers[i]);
+    mSubscribers.clear();
+    if (mSocket >= 0)
+    {
+        ::close(mSocket);
+        unlink(mPath.c_str());
+        mSocket = -1;
+    }
+}
+
+bool AlertOutput::isOpen() const
+{
+    return mSocket >= 0;
+}
+
+
+//
+// Output
+//
+
+// Send the features of a frame to every subscriber. Safe to call from the
+// threads of several streams at once.
+void AlertOutput::publish(unsigned int iStream, const FrameFeatures& iFeatures)
+{
+    if (!isOpen())
+        return;
+
+    AlertMessage tMessage;
+    encode(iStream, iFeatures, tMessage);
+
+    QMutexLocker tLocker(&mMutex);
+    accept();
+    tMessage.sequence = mSequence++;
+    for (size_t i = 0; i < mSubscribers.size(); )
+    {
+        if (send(mSubscribers[i], &tMessage, sizeof(tMessage), MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t) sizeof(tMessage))
+            i++;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            mDropped++;
+            i++;
+        }
+        else
+        {
+            ::close(mSubscribers[i]);
+            mSubscribers.erase(mSubscribers.begin() + i);
+        }
+    }
+}
+
+
+//
+// Statistics
+//
+
+// Messages a subscriber wasn't ready to receive
+unsigned long AlertOutput::dropped()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mDropped;
+}
+
+
+//
+// Output of the process
+//
+
+// Like the logger, the output never gets destroyed, as streams may still be
+// publishing while the process exits (close it to remove the socket)
+AlertOutput& AlertOutput::instance()
+{
+    static AlertOutput* tOutput = new AlertOutput();
+    return *tOutput;
+}
+
+
+//
+// Auxiliary
+//
+
+// Take on the subscribers which connected since the last message
+void AlertOutput::accept()
+{
+    for (;;)
+    {
+        int tSubscriber = ::accept(mSocket, 0, 0);
+        if (tSubscriber < 0)
+            break;
+        fcntl(tSubscriber, F_SETFL, fcntl(tSubscriber, F_GETFL) | O_NONBLOCK);
+        mSubscribers.push_back(tSubscriber);
+    }
+}
+
+static int16_t clamp16(int iValue)
+{
+    return (int16_t) std::max(-32768, std::min(32767, iValue));
+}
+
+static AlertBox box(const cv::Rect& iRect)
+{
+    AlertBox tBox;
+    tBox.x = clamp16(iRect.x);
+    tBox.y = clamp16(iRect.y);
+    tBox.width = clamp16(iRect.width);
+    tBox.height = clamp16(iRect.height);
+    return tBox;
+}
+
+void AlertOutput::encode(unsigned int iStream, const FrameFeatures& iFeatures, AlertMessage& oMessage)
+{
+    memset(&oMessage, 0, sizeof(oMessage));
+    oMessage.magic = ALERT_MAGIC;
+    oMessage.version = ALERT_VERSION;
+    oMessage.size = sizeof(oMessage);
+    oMessage.stream = iStream;
+    oMessage.frame = iFeatures.frame;
+    oMessage.timestamp = iFeatures.timestamp;
+    timespec tNow;
+    clock_gettime(CLOCK_MONOTONIC, &tNow);
+    oMessage.sent = (uint64_t) tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000;
+
+    // Tram ahead
+    if (iFeatures.tram.area() > 0)
+    {
+        oMessage.flags |= ALERT_TRAM_VALID;
+        oMessage.tram = box(iFeatures.tram);
+        oMessage.tramDistance = iFeatures.tramDistance;
+    }
+    if (iFeatures.timeToCollision > 0)
+    {
+        oMessage.flags |= ALERT_TTC_VALID;
+        oMessage.closingSpeed = iFeatures.closingSpeed;
+        oMessage.timeToCollision = iFeatures.timeToCollision;
+    }
+
+    // Hazards, the most urgent ones if there are too many
+    oMessage.hazards = std::min(iFeatures.hazards.size(), (size_t) ALERT_MAX_HAZARDS);
+    for (int i = 0; i < oMessage.hazards; i++)
+    {
+        const Hazard& tHazard = iFeatures.hazards[i];
+        oMessage.hazard[i].id = tHazard.id;
+        oMessage.hazard[i].type = tHazard.type;
+        oMessage.hazard[i].inside = tHazard.inside;
+        oMessage.hazard[i].box = box(tHazard.rect);
+        oMessage.hazard[i].distance = tHazard.distance;
+    }
+
+    // Rails
+    encode(iFeatures.tracks.first, oMessage.left, oMessage.leftPoints);
+    encode(iFeatures.tracks.second, oMessage.right, oMessage.rightPoints);
+    if (oMessage.leftPoints > 0 && oMessage.rightPoints > 0)
+        oMessage.flags |= ALERT_TRACKS_VALID;
+}
+
+// Pick points evenly along a rail, always keeping both ends
+void AlertOutput::encode(const Track& iTrack, AlertPoint* oPoints, uint8_t& oCount)
+{
+    size_t tCount = std::min(iTrack.size(), (size_t) ALERT_TRACK_POINTS);
+    for (size_t i = 0; i < tCount; i++)
+    {
+        size_t tIndex = tCount > 1 ? i * (iTrack.size() - 1) / (tCount - 1) : 0;
+        oPoints[i].x = clamp16(iTrack[tIndex].x);
+        oPoints[i].y = clamp16(iTrack[tIndex].y);
+    }
+    oCount = tCount;
+}
@@ -0,0 +1,69 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef ALERTOUTPUT_H
+#define ALERTOUTPUT_H
+
+// Includes
+#include <string>
+#include <vector>
+#include <QMutex>
+#include "framefeatures.h"
+#include "alertmessage.h"
+
+/*
+  The AlertOutput sends an AlertMessage for every processed frame to any
+  local process subscribed to it, such as the onboard warning unit. It
+  listens on a UNIX domain socket of the sequenced packet type, so every
+  message arrives whole and on its own, and subscribers simply connect and
+  read.
+
+  Messages get sent right from the thread which finished the frame, once
+  its features are complete: there's no queue, no thread hop and no text
+  encoding in between. Sending never blocks; a subscriber which doesn't
+  keep up misses messages (which the sequence number reveals), and one
+  which goes away gets dropped.
+  */
+class AlertOutput
+{
+public:
+    // Construction and destruction
+    AlertOutput();
+    ~AlertOutput();
+
+    // Socket
+    bool open(const std::string& iPath);
+    void close();
+    bool isOpen() const;
+
+    // Output
+    void publish(unsigned int iStream, const FrameFeatures& iFeatures);
+
+    // Statistics
+    unsigned long dropped();
+
+    // Output of the process
+    static AlertOutput& instance();
+
+private:
+    // Auxiliary
+    void accept();
+    static void encode(unsigned int iStream, const FrameFeatures& iFeatures, AlertMessage& oMessage);
+    static void encode(const Track& iTrack, AlertPoint* oPoints, uint8_t& oCount);
+
+    // Member data
+    volatile int mSocket;
+    std::string mPath;
+    QMutex mMutex;
+    std::vector<int> mSubscribers;
+    uint32_t mSequence;
+    unsigned long mDropped;
+
+    // Disable copying
+    AlertOutput(const AlertOutput&);
+    AlertOutput& operator=(const AlertOutput&);
+};
+
+#endif // ALERTOUTPUT_H
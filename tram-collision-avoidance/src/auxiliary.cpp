@@ -4,6 +4,11 @@
 
 // Includes
 #include "auxiliary.h"
+#include <limits>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 //
@@ -130,3 +135,265 @@ double distance_segment2segment(const Line& iSegmentA, const Line& iSegmentB, cv
 
     return tDistanceBest;
 }
+
+// Calculate the intersection over union of two rectangles.
+double overlap_rects(const cv::Rect& iRectA, const cv::Rect& iRectB)
+{
+    double tIntersection = (iRectA & iRectB).area();
+    double tUnion = iRectA.area() + iRectB.area() - tIntersection;
+    if (tUnion <= 0)
+        return 0;
+    return tIntersection / tUnion;
+}
+
+// Return True if the convex quadrilateral and the rectangle overlap.
+bool intersect_quad_rect(const cv::Point2f iQuad[4], const cv::Rect& iRect)
+{
+    // Separating axis theorem: the rectangle's own axes first, which are
+    // the cheapest and reject most cases
+    float tMinX = iQuad[0].x, tMaxX = iQuad[0].x, tMinY = iQuad[0].y, tMaxY = iQuad[0].y;
+    for (int i = 1; i < 4; i++)
+    {
+        tMinX = std::min(tMinX, iQuad[i].x);
+        tMaxX = std::max(tMaxX, iQuad[i].x);
+        tMinY = std::min(tMinY, iQuad[i].y);
+        tMaxY = std::max(tMaxY, iQuad[i].y);
+    }
+    if (tMaxX < iRect.x || tMinX > iRect.x + iRect.width || tMaxY < iRect.y || tMinY > iRect.y + iRect.height)
+        return false;
+
+    // Then the normals of the edges of the quadrilateral
+    cv::Point2f tCorners[4] = {
+        cv::Point2f(iRect.x, iRect.y),
+        cv::Point2f(iRect.x + iRect.width, iRect.y),
+        cv::Point2f(iRect.x + iRect.width, iRect.y + iRect.height),
+        cv::Point2f(iRect.x, iRect.y + iRect.height)
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        cv::Point2f tEdge = iQuad[(i+1)%4] - iQuad[i];
+        cv::Point2f tNormal(-tEdge.y, tEdge.x);
+        float tQuadMin = tNormal.dot(iQuad[0]), tQuadMax = tQuadMin;
+        float tRectMin = tNormal.dot(tCorners[0]), tRectMax = tRectMin;
+        for (int j = 1; j < 4; j++)
+        {
+            float tQuad = tNormal.dot(iQuad[j]);
+            tQuadMin = std::min(tQuadMin, tQuad);
+            tQuadMax = std::max(tQuadMax, tQuad);
+            float tRect = tNormal.dot(tCorners[j]);
+            tRectMin = std::min(tRectMin, tRect);
+            tRectMax = std::max(tRectMax, tRect);
+        }
+        if (tQuadMax < tRectMin || tRectMax < tQuadMin)
+            return false;
+    }
+    return true;
+}
+
+// Find the column where a polyline crosses a row. Return False if it
+// doesn't cross it.
+bool interpolate_polyline(const std::vector<cv::Point>& iPolyline, int iRow, double& oColumn)
+{
+    for (size_t i = 0; i + 1 < iPolyline.size(); i++)
+    {
+        const cv::Point& tA = iPolyline[i];
+        const cv::Point& tB = iPolyline[i+1];
+        if (iRow < std::min(tA.y, tB.y) || iRow > std::max(tA.y, tB.y))
+            continue;
+        if (tA.y == tB.y)
+            oColumn = (tA.x + tB.x) / 2.0;
+        else
+            oColumn = tA.x + (tB.x - tA.x) * (double) (iRow - tA.y) / (tB.y - tA.y);
+        return true;
+    }
+    return false;
+}
+
+
+//
+// Batch geometry
+//
+
+// Squared distance between the point and the segment starting at (x, y)
+// with direction (dx, dy).
+static inline float distance2_point2segment(float iPx, float iPy, float iX, float iY, float iDx, float iDy)
+{
+    float tRx = iPx - iX, tRy = iPy - iY;
+    float tLength2 = iDx * iDx + iDy * iDy;
+    float t = (tLength2 > 0) ? (tRx * iDx + tRy * iDy) / tLength2 : 0;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    float tEx = tRx - t * iDx, tEy = tRy - t * iDy;
+    return tEx * tEx + tEy * tEy;
+}
+
+// Whether the segments, given by a start point and a direction, intersect.
+static inline bool intersect_segment2segment(float iAx, float iAy, float iAdx, float iAdy, float iBx, float iBy, float iBdx, float iBdy)
+{
+    float tDenominator = iBdx * iAdy - iBdy * iAdx;
+    if (tDenominator == 0)
+        return false;
+    float s = (iAdx * (iBy - iAy) + iAdy * (iAx - iBx)) / tDenominator;
+    float t = (iBdx * (iAy - iBy) + iBdy * (iBx - iAx)) / -tDenominator;
+    return (s >= 0 && s <= 1 && t >= 0 && t <= 1);
+}
+
+#ifdef __SSE2__
+// Four lanes of distance2_point2segment. A degenerate segment divides by
+// zero, but the resulting NaN gets clamped to 0 (max returns its second
+// operand when either is NaN).
+static inline __m128 distance2_point2segment(__m128 iPx, __m128 iPy, __m128 iX, __m128 iY, __m128 iDx, __m128 iDy)
+{
+    __m128 tRx = _mm_sub_ps(iPx, iX), tRy = _mm_sub_ps(iPy, iY);
+    __m128 tLength2 = _mm_add_ps(_mm_mul_ps(iDx, iDx), _mm_mul_ps(iDy, iDy));
+    __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(tRx, iDx), _mm_mul_ps(tRy, iDy)), tLength2);
+    t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128 tEx = _mm_sub_ps(tRx, _mm_mul_ps(t, iDx)), tEy = _mm_sub_ps(tRy, _mm_mul_ps(t, iDy));
+    return _mm_add_ps(_mm_mul_ps(tEx, tEx), _mm_mul_ps(tEy, tEy));
+}
+
+// Four lanes of intersect_segment2segment, as a mask of all ones where the
+// segments intersect.
+static inline __m128 intersect_segment2segment(__m128 iAx, __m128 iAy, __m128 iAdx, __m128 iAdy, __m128 iBx, __m128 iBy, __m128 iBdx, __m128 iBdy)
+{
+    __m128 tZero = _mm_setzero_ps(), tOne = _mm_set1_ps(1.0f);
+    __m128 tDenominator = _mm_sub_ps(_mm_mul_ps(iBdx, iAdy), _mm_mul_ps(iBdy, iAdx));
+    __m128 s = _mm_div_ps(_mm_add_ps(_mm_mul_ps(iAdx, _mm_sub_ps(iBy, iAy)), _mm_mul_ps(iAdy, _mm_sub_ps(iAx, iBx))), tDenominator);
+    __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(iBdx, _mm_sub_ps(iAy, iBy)), _mm_mul_ps(iBdy, _mm_sub_ps(iBx, iAx))), _mm_sub_ps(tZero, tDenominator));
+    __m128 tMask = _mm_cmpneq_ps(tDenominator, tZero);
+    tMask = _mm_and_ps(tMask, _mm_and_ps(_mm_cmpge_ps(s, tZero), _mm_cmple_ps(s, tOne)));
+    tMask = _mm_and_ps(tMask, _mm_and_ps(_mm_cmpge_ps(t, tZero), _mm_cmple_ps(t, tOne)));
+    return tMask;
+}
+#endif
+
+// Calculate the squared distance between the segment and each segment (0
+// if they intersect), which is the smallest distance between an end point
+// of one segment and the other segment.
+void distance2_segment2segments(const Line& iSegment, const float* iX1, const float* iY1, const float* iX2, const float* iY2,
+                                const float* iDx, const float* iDy, size_t iCount, float* oDistances2)
+{
+    float tAx = iSegment.first.x, tAy = iSegment.first.y;
+    float tBx = iSegment.second.x, tBy = iSegment.second.y;
+    float tAdx = tBx - tAx, tAdy = tBy - tAy;
+
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128 tAx4 = _mm_set1_ps(tAx), tAy4 = _mm_set1_ps(tAy), tBx4 = _mm_set1_ps(tBx), tBy4 = _mm_set1_ps(tBy);
+    __m128 tAdx4 = _mm_set1_ps(tAdx), tAdy4 = _mm_set1_ps(tAdy);
+    for (; i + 4 <= iCount; i += 4)
+    {
+        __m128 tX1 = _mm_loadu_ps(iX1 + i), tY1 = _mm_loadu_ps(iY1 + i);
+        __m128 tX2 = _mm_loadu_ps(iX2 + i), tY2 = _mm_loadu_ps(iY2 + i);
+        __m128 tDx = _mm_loadu_ps(iDx + i), tDy = _mm_loadu_ps(iDy + i);
+
+        __m128 tDistance2 = distance2_point2segment(tAx4, tAy4, tX1, tY1, tDx, tDy);
+        tDistance2 = _mm_min_ps(tDistance2, distance2_point2segment(tBx4, tBy4, tX1, tY1, tDx, tDy));
+        tDistance2 = _mm_min_ps(tDistance2, distance2_point2segment(tX1, tY1, tAx4, tAy4, tAdx4, tAdy4));
+        tDistance2 = _mm_min_ps(tDistance2, distance2_point2segment(tX2, tY2, tAx4, tAy4, tAdx4, tAdy4));
+
+        __m128 tIntersect = intersect_segment2segment(tAx4, tAy4, tAdx4, tAdy4, tX1, tY1, tDx, tDy);
+        _mm_storeu_ps(oDistances2 + i, _mm_andnot_ps(tIntersect, tDistance2));
+    }
+#endif
+    for (; i < iCount; i++)
+    {
+        float tDx = iDx[i], tDy = iDy[i];
+        if (intersect_segment2segment(tAx, tAy, tAdx, tAdy, iX1[i], iY1[i], tDx, tDy))
+        {
+            oDistances2[i] = 0;
+            continue;
+        }
+        float tDistance2 = distance2_point2segment(tAx, tAy, iX1[i], iY1[i], tDx, tDy);
+        tDistance2 = std::min(tDistance2, distance2_point2segment(tBx, tBy, iX1[i], iY1[i], tDx, tDy));
+        tDistance2 = std::min(tDistance2, distance2_point2segment(iX1[i], iY1[i], tAx, tAy, tAdx, tAdy));
+        tDistance2 = std::min(tDistance2, distance2_point2segment(iX2[i], iY2[i], tAx, tAy, tAdx, tAdy));
+        oDistances2[i] = tDistance2;
+    }
+}
+
+
+//
+// Assignment
+//
+
+// Assign every row of the cost matrix to a distinct column, minimizing
+// the total cost (Hungarian method). Rows which don't get a column
+// (because there are more rows than columns) are assigned -1.
+void assign_hungarian(const std::vector<std::vector<double> >& iCost, std::vector<int>& oAssignment)
+{
+    size_t tRows = iCost.size();
+    size_t tColumns = (tRows > 0) ? iCost[0].size() : 0;
+    oAssignment.assign(tRows, -1);
+    if (tRows == 0 || tColumns == 0)
+        return;
+
+    // Pad to a square matrix, where the padding costs as much as the
+    // worst real entry (so it never gets preferred)
+    size_t n = std::max(tRows, tColumns);
+    double tPadding = 0;
+    for (size_t i = 0; i < tRows; i++)
+        for (size_t j = 0; j < tColumns; j++)
+            tPadding = std::max(tPadding, iCost[i][j]);
+
+    // Shortest augmenting paths with potentials, one row at a time (all
+    // arrays are 1-based, with index 0 as a sentinel column)
+    const double tInfinity = std::numeric_limits<double>::max();
+    std::vector<double> u(n+1, 0), v(n+1, 0), tMinimum(n+1);
+    std::vector<size_t> tMatch(n+1, 0), tWay(n+1, 0);
+    std::vector<bool> tUsed(n+1);
+    for (size_t i = 1; i <= n; i++)
+    {
+        tMatch[0] = i;
+        size_t j0 = 0;
+        std::fill(tMinimum.begin(), tMinimum.end(), tInfinity);
+        std::fill(tUsed.begin(), tUsed.end(), false);
+        do
+        {
+            tUsed[j0] = true;
+            size_t i0 = tMatch[j0], j1 = 0;
+            double tDelta = tInfinity;
+            for (size_t j = 1; j <= n; j++)
+            {
+                if (tUsed[j])
+                    continue;
+                double tCost = (i0 <= tRows && j <= tColumns) ? iCost[i0-1][j-1] : tPadding;
+                double tReduced = tCost - u[i0] - v[j];
+                if (tReduced < tMinimum[j])
+                {
+                    tMinimum[j] = tReduced;
+                    tWay[j] = j0;
+                }
+                if (tMinimum[j] < tDelta)
+                {
+                    tDelta = tMinimum[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= n; j++)
+            {
+                if (tUsed[j])
+                {
+                    u[tMatch[j]] += tDelta;
+                    v[j] -= tDelta;
+                }
+                else
+                    tMinimum[j] -= tDelta;
+            }
+            j0 = j1;
+        } while (tMatch[j0] != 0);
+
+        // Flip the augmenting path
+        do
+        {
+            size_t j1 = tWay[j0];
+            tMatch[j0] = tMatch[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    for (size_t j = 1; j <= tColumns; j++)
+    {
+        if (tMatch[j] != 0 && tMatch[j] <= tRows)
+            oAssignment[tMatch[j]-1] = j-1;
+    }
+}
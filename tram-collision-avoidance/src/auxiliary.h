@@ -8,10 +8,11 @@
 
 // Includes
 #include "opencv/cv.h"
-#include <QPair>
+#include <vector>
+#include <utility>
 
 // Type definitions
-typedef QPair<cv::Point, cv::Point> Line;
+typedef std::pair<cv::Point, cv::Point> Line;
 
 
 //
@@ -32,4 +33,40 @@ bool intersect_segments(const Line& iSegmentA, const Line& iSegmentB, cv::Point&
 // (near_x1, near_y1) and (near_x2, near_y2).
 double distance_segment2segment(const Line& iSegmentA, const Line& iSegmentB, cv::Point& oIntersectA, cv::Point& oIntersectB);
 
+// Calculate the intersection over union of two rectangles.
+double overlap_rects(const cv::Rect& iRectA, const cv::Rect& iRectB);
+
+// Return True if the convex quadrilateral and the rectangle overlap.
+bool intersect_quad_rect(const cv::Point2f iQuad[4], const cv::Rect& iRect);
+
+// Find the column where a polyline crosses a row. Return False if it
+// doesn't cross it.
+bool interpolate_polyline(const std::vector<cv::Point>& iPolyline, int iRow, double& oColumn);
+
+
+//
+// Batch geometry
+//
+
+// The batch functions compare one segment with a whole set of segments,
+// given as arrays of their end points, and work with squared distances in
+// single precision. They process four segments at a time when SSE2 is
+// available.
+
+// Calculate the squared distance between the segment and each segment (0
+// if they intersect), given their directions (from the first point towards
+// the second one) as well.
+void distance2_segment2segments(const Line& iSegment, const float* iX1, const float* iY1, const float* iX2, const float* iY2,
+                                const float* iDx, const float* iDy, size_t iCount, float* oDistances2);
+
+
+//
+// Assignment
+//
+
+// Assign every row of the cost matrix to a distinct column, minimizing
+// the total cost (Hungarian method). Rows which don't get a column
+// (because there are more rows than columns) are assigned -1.
+void assign_hungarian(const std::vector<std::vector<double> >& iCost, std::vector<int>& oAssignment);
+
 #endif // AUXILIARY_H
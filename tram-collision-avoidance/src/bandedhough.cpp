@@ -0,0 +1,233 @@
+//
+// Configuration
+//
+
+// Includes
+#include "bandedhough.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+// Transform properties
+#define HOUGH_MAX_CANDIDATES 256    // accumulator bins inspected per band
+
+
+//
+// Construction and destruction
+//
+
+BandedHough::BandedHough()
+{
+}
+
+
+//
+// Bands
+//
+
+void BandedHough::clear()
+{
+    mBands.clear();
+}
+
+// Add a rectangular band, searched for lines with a normal between the given
+// angles (which may exceed PI, in order to express ranges around vertical lines)
+void BandedHough::addBand(const cv::Rect& iArea, double iThetaMin, double iThetaMax, double iThetaStep)
+{
+    if (iArea.height <= 0 || iArea.width <= 0 || iThetaMax < iThetaMin)
+        return;
+
+    Band tBand;
+    tBand.top = iArea.y;
+    tBand.left.assign(iArea.height, iArea.x);
+    tBand.right.assign(iArea.height, iArea.x + iArea.width - 1);
+    tBand.thetaMin = iThetaMin;
+    tBand.thetaStep = iThetaStep;
+    tBand.thetas = (int) ((iThetaMax - iThetaMin) / iThetaStep) + 1;
+    mBands.push_back(tBand);
+}
+
+// Add a band around a polyline running top to bottom, searched for lines
+// within the given angle of its segments
+void BandedHough::addBand(const Track& iCentre, int iHalfWidth, double iThetaMargin, double iThetaStep)
+{
+    if (iCentre.size() < 2 || iCentre.back().y <= iCentre.front().y)
+        return;
+
+    Band tBand;
+    tBand.top = iCentre.front().y;
+    double tThetaMin = 2*CV_PI, tThetaMax = 0;
+    for (size_t i = 0; i + 1 < iCentre.size(); i++)
+    {
+        cv::Point tA = iCentre[i], tB = iCentre[i+1];
+        if (tB.y < tA.y)
+            continue;
+
+        // Segments point downwards, so their normals lie between PI/2 and 3*PI/2
+        double tTheta = atan2((double) (tB.y - tA.y), (double) (tB.x - tA.x)) + CV_PI/2;
+        tThetaMin = std::min(tThetaMin, tTheta);
+        tThetaMax = std::max(tThetaMax, tTheta);
+
+        int tStart = (i == 0) ? tA.y : tA.y + 1;
+        for (int y = tStart; y <= tB.y; y++)
+        {
+            double tX = (tB.y == tA.y) ? tB.x : tA.x + (tB.x - tA.x) * (double) (y - tA.y) / (tB.y - tA.y);
+            while ((int) tBand.left.size() <= y - tBand.top)
+            {
+                tBand.left.push_back(cvRound(tX) - iHalfWidth);
+                tBand.right.push_back(cvRound(tX) + iHalfWidth);
+            }
+        }
+    }
+    if (tBand.left.size() == 0)
+        return;
+
+    tBand.thetaMin = tThetaMin - iThetaMargin;
+    tBand.thetaStep = iThetaStep;
+    tBand.thetas = (int) ((tThetaMax - tThetaMin + 2*iThetaMargin) / iThetaStep) + 1;
+    mBands.push_back(tBand);
+}
+
+
+//
+// Detection
+//
+
+// Find line segments in a binary image. The parameters mean the same as the
+// ones of cv::HoughLinesP, with a distance resolution of one pixel.
+void BandedHough::detect(const cv::Mat& iImage, int iThreshold, double iMinLength, double iMaxGap, std::vector<cv::Vec4i>& oLines)
+{
+    CV_Assert(iImage.type() == CV_8UC1);
+    oLines.clear();
+
+    // Every point lies within this distance from the origin, whatever the angle
+    int tRhoOffset = iImage.cols + iImage.rows;
+    int tRhos = 2*tRhoOffset + 1;
+
+    for (size_t b = 0; b < mBands.size(); b++)
+    {
+        const Band& tBand = mBands[b];
+        gather(iImage, tBand);
+        if ((int) mX.size() < iThreshold)
+            continue;
+
+        accumulate(tBand, tRhoOffset, tRhos);
+        extract(tRhoOffset, tRhos, iThreshold, iMinLength, iMaxGap, oLines);
+    }
+}
+
+
+//
+// Auxiliary
+//
+
+// Collect the coordinates of all set pixels within a band
+void BandedHough::gather(const cv::Mat& iImage, const Band& iBand)
+{
+    mX.clear();
+    mY.clear();
+
+    int tFirst = std::max(0, iBand.top);
+    int tLast = std::min(iImage.rows, iBand.top + (int) iBand.left.size());
+    for (int y = tFirst; y < tLast; y++)
+    {
+        const unsigned char* tRow = iImage.ptr<unsigned char>(y);
+        int tLeft = std::max(0, iBand.left[y - iBand.top]);
+        int tRight = std::min(iImage.cols - 1, iBand.right[y - iBand.top]);
+        for (int x = tLeft; x <= tRight; x++)
+        {
+            if (tRow[x] != 0)
+            {
+                mX.push_back((float) x);
+                mY.push_back((float) y);
+            }
+        }
+    }
+}
+
+// Vote for every angle of the band. The distances of all points get computed
+// in a separate pass, which the compiler can vectorize.
+void BandedHough::accumulate(const Band& iBand, int iRhoOffset, int iRhos)
+{
+    mCos.resize(iBand.thetas);
+    mSin.resize(iBand.thetas);
+    for (int k = 0; k < iBand.thetas; k++)
+    {
+        double tTheta = iBand.thetaMin + k * iBand.thetaStep;
+        mCos[k] = (float) cos(tTheta);
+        mSin[k] = (float) sin(tTheta);
+    }
+
+    // Keeps its capacity, so this doesn't allocate once it has grown
+    mAccumulator.assign(iBand.thetas * iRhos, 0);
+    mIndices.resize(mX.size());
+
+    const size_t tPoints = mX.size();
+    const float* tX = &mX[0];
+    const float* tY = &mY[0];
+    int* tIndices = &mIndices[0];
+    for (int k = 0; k < iBand.thetas; k++)
+    {
+        const float c = mCos[k], s = mSin[k];
+        const float tOffset = iRhoOffset + 0.5f;
+        for (size_t i = 0; i < tPoints; i++)
+            tIndices[i] = (int) (tX[i] * c + tY[i] * s + tOffset);
+
+        int* tVotes = &mAccumulator[k * iRhos];
+        for (size_t i = 0; i < tPoints; i++)
+            tVotes[tIndices[i]]++;
+    }
+}
+
+// Turn the strongest bins into segments. Like cv::HoughLinesP, every point
+// only contributes to a single segment, which keeps the neighbouring bins
+// of a line from producing duplicates of it.
+void BandedHough::extract(int iRhoOffset, int iRhos, int iThreshold, double iMinLength, double iMaxGap, std::vector<cv::Vec4i>& oLines)
+{
+    std::vector<std::pair<int, int> > tCandidates;
+    for (size_t i = 0; i < mAccumulator.size(); i++)
+    {
+        if (mAccumulator[i] >= iThreshold)
+            tCandidates.push_back(std::make_pair(mAccumulator[i], (int) i));
+    }
+    size_t tCount = std::min(tCandidates.size(), (size_t) HOUGH_MAX_CANDIDATES);
+    std::partial_sort(tCandidates.begin(), tCandidates.begin() + tCount, tCandidates.end(), std::greater<std::pair<int, int> >());
+
+    mUsed.assign(mX.size(), 0);
+    std::vector<std::pair<float, int> > tMembers;
+    for (size_t n = 0; n < tCount; n++)
+    {
+        int k = tCandidates[n].second / iRhos;
+        int tRho = tCandidates[n].second % iRhos;
+        const float c = mCos[k], s = mSin[k];
+        const float tOffset = iRhoOffset + 0.5f;
+
+        // Collect the remaining points of the bin, ordered along the line
+        tMembers.clear();
+        for (size_t i = 0; i < mX.size(); i++)
+        {
+            if (!mUsed[i] && (int) (mX[i] * c + mY[i] * s + tOffset) == tRho)
+                tMembers.push_back(std::make_pair(mY[i] * c - mX[i] * s, (int) i));
+        }
+        if ((int) tMembers.size() < iThreshold)
+            continue;
+        std::sort(tMembers.begin(), tMembers.end());
+
+        // Split into segments at every gap
+        size_t tStart = 0;
+        for (size_t i = 1; i <= tMembers.size(); i++)
+        {
+            if (i < tMembers.size() && tMembers[i].first - tMembers[i-1].first <= iMaxGap)
+                continue;
+
+            if (tMembers[i-1].first - tMembers[tStart].first >= iMinLength)
+            {
+                int tFirst = tMembers[tStart].second, tLast = tMembers[i-1].second;
+                oLines.push_back(cv::Vec4i((int) mX[tFirst], (int) mY[tFirst], (int) mX[tLast], (int) mY[tLast]));
+                for (size_t j = tStart; j < i; j++)
+                    mUsed[tMembers[j].second] = 1;
+            }
+            tStart = i;
+        }
+    }
+}
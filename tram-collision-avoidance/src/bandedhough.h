@@ -0,0 +1,64 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef BANDEDHOUGH_H
+#define BANDEDHOUGH_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include "framefeatures.h"
+
+/*
+  The BandedHough transform finds line segments like cv::HoughLinesP does,
+  but only considers the pixels inside a set of bands, and for each band only
+  a limited range of angles. Rails occupy a narrow set of orientations, so
+  most of the work of a full transform would be wasted on them.
+
+  The points of a band are gathered in separate coordinate arrays, so the
+  votes for one angle can be computed for all points at once; the accumulator
+  is laid out with one contiguous row of distances per angle. All buffers
+  persist between frames, so keep one transform around rather than
+  constructing it every time.
+  */
+class BandedHough
+{
+public:
+    // Construction and destruction
+    BandedHough();
+
+    // Bands
+    void clear();
+    void addBand(const cv::Rect& iArea, double iThetaMin, double iThetaMax, double iThetaStep);
+    void addBand(const Track& iCentre, int iHalfWidth, double iThetaMargin, double iThetaStep);
+
+    // Detection
+    void detect(const cv::Mat& iImage, int iThreshold, double iMinLength, double iMaxGap, std::vector<cv::Vec4i>& oLines);
+
+private:
+    // A band covers a range of columns on every row it spans
+    struct Band
+    {
+        int top;
+        std::vector<int> left, right;
+        double thetaMin, thetaStep;
+        int thetas;
+    };
+
+    // Auxiliary
+    void gather(const cv::Mat& iImage, const Band& iBand);
+    void accumulate(const Band& iBand, int iRhoOffset, int iRhos);
+    void extract(int iRhoOffset, int iRhos, int iThreshold, double iMinLength, double iMaxGap, std::vector<cv::Vec4i>& oLines);
+
+    // Member data
+    std::vector<Band> mBands;
+    std::vector<float> mX, mY;
+    std::vector<float> mCos, mSin;
+    std::vector<int> mIndices;
+    std::vector<int> mAccumulator;
+    std::vector<unsigned char> mUsed;
+};
+
+#endif // BANDEDHOUGH_H
@@ -0,0 +1,112 @@
+//
+// Configuration
+//
+
+// Includes
+#include "bufferpool.h"
+#include <QMutexLocker>
+
+// Pool properties
+#define POOL_HEADER 16                      // in front of every buffer, holding its size
+#define POOL_MAX_PER_SIZE 8                 // free buffers kept of a single size
+#define POOL_MAX_BYTES (256*1024*1024)      // free buffers kept in total, in bytes
+
+
+//
+// Construction and destruction
+//
+
+BufferPool::BufferPool() : mFreeBytes(0), mRecycled(0), mAllocated(0)
+{
+}
+
+
+//
+// Matrix allocator interface
+//
+
+void BufferPool::allocate(int iDims, const int* iSizes, int iType, int*& oRefcount, uchar*& oDatastart, uchar*& oData, size_t* oStep)
+{
+    // Same layout as the default allocator: continuous, with the reference
+    // counter right after the data
+    size_t tTotal = CV_ELEM_SIZE(iType);
+    for (int i = iDims - 1; i >= 0; i--)
+    {
+        oStep[i] = tTotal;
+        tTotal *= iSizes[i];
+    }
+    size_t tSize = cv::alignSize(tTotal, (int) sizeof(*oRefcount)) + sizeof(*oRefcount);
+
+    uchar* tBuffer = 0;
+    {
+        QMutexLocker tLocker(&mMutex);
+        std::map<size_t, std::vector<uchar*> >::iterator tFree = mFree.find(tSize);
+        if (tFree != mFree.end() && !tFree->second.empty())
+        {
+            tBuffer = tFree->second.back();
+            tFree->second.pop_back();
+            mFreeBytes -= tSize;
+            mRecycled++;
+        }
+        else
+            mAllocated++;
+    }
+    if (tBuffer == 0)
+    {
+        tBuffer = (uchar*) cv::fastMalloc(POOL_HEADER + tSize);
+        *(size_t*) tBuffer = tSize;
+    }
+
+    oDatastart = oData = tBuffer + POOL_HEADER;
+    oRefcount = (int*) (oDatastart + tSize - sizeof(*oRefcount));
+    *oRefcount = 1;
+}
+
+void BufferPool::deallocate(int*, uchar* iDatastart, uchar*)
+{
+    if (iDatastart == 0)
+        return;
+    uchar* tBuffer = iDatastart - POOL_HEADER;
+    size_t tSize = *(size_t*) tBuffer;
+
+    {
+        QMutexLocker tLocker(&mMutex);
+        std::vector<uchar*>& tFree = mFree[tSize];
+        if (tFree.size() < POOL_MAX_PER_SIZE && mFreeBytes + tSize <= POOL_MAX_BYTES)
+        {
+            tFree.push_back(tBuffer);
+            mFreeBytes += tSize;
+            return;
+        }
+    }
+    cv::fastFree(tBuffer);
+}
+
+
+//
+// Statistics
+//
+
+// Buffers handed out again rather than allocated
+unsigned long BufferPool::recycled()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mRecycled;
+}
+
+unsigned long BufferPool::allocated()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mAllocated;
+}
+
+
+//
+// Pool of the process
+//
+
+BufferPool* BufferPool::instance()
+{
+    static BufferPool* tPool = new BufferPool();
+    return tPool;
+}
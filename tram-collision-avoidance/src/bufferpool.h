@@ -0,0 +1,52 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+// Includes
+#include "opencv/cv.h"
+#include <map>
+#include <vector>
+#include <QMutex>
+
+/*
+  The BufferPool is a matrix allocator which recycles image buffers instead
+  of returning them to the heap. A stream keeps producing images of the same
+  few sizes (the input frame, its pyramid levels, their grayscale versions),
+  so after the first frames every such image reuses a buffer which is
+  already mapped, rather than going through malloc() and page faults again.
+
+  Set it as the allocator of a matrix before it gets created. Buffers are
+  kept per size in bytes, and only up to a limit: the rest goes back to the
+  heap. The pool is shared by all threads, and never gets destroyed, as
+  matrices may outlive any object which would own it.
+  */
+class BufferPool : public cv::MatAllocator
+{
+public:
+    // Matrix allocator interface
+    void allocate(int iDims, const int* iSizes, int iType, int*& oRefcount, uchar*& oDatastart, uchar*& oData, size_t* oStep);
+    void deallocate(int* iRefcount, uchar* iDatastart, uchar* iData);
+
+    // Statistics
+    unsigned long recycled();
+    unsigned long allocated();
+
+    // Pool of the process
+    static BufferPool* instance();
+
+private:
+    // Construction and destruction
+    BufferPool();
+
+    // Member data
+    QMutex mMutex;
+    std::map<size_t, std::vector<uchar*> > mFree;
+    size_t mFreeBytes;
+    unsigned long mRecycled, mAllocated;
+};
+
+#endif // BUFFERPOOL_H
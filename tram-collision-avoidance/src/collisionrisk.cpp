@@ -0,0 +1,167 @@
+//
+// Configuration
+//
+
+// Includes
+#include "collisionrisk.h"
+#include "groundplane.h"
+#include "auxiliary.h"
+#include <algorithm>
+
+// Feature properties (widths in meters, lengths in pixels of the reference resolution)
+#define RISK_TRAM_WIDTH 2.5         // width of a tram
+#define RISK_SWAY 0.3               // overhang and sway, on each side
+#define RISK_NEAR 1.5               // margin next to the envelope which is still a risk
+#define RISK_ROW_STEP 20            // between sampled rows
+#define RISK_BOUNDS_MARGIN 60       // around the corridor, for detections straddling it
+
+
+//
+// Construction and destruction
+//
+
+CollisionRisk::CollisionRisk(FrameContext* iContext) : Component(iContext)
+{
+}
+
+
+//
+// Component interface
+//
+
+void CollisionRisk::preprocess()
+{
+    debug().setBackground(*frame());
+}
+
+// Order hazards by urgency
+static bool hazard_before(const Hazard& iHazardA, const Hazard& iHazardB)
+{
+    if (iHazardA.inside != iHazardB.inside)
+        return iHazardA.inside;
+    if ((iHazardA.distance > 0) != (iHazardB.distance > 0))
+        return iHazardA.distance > 0;
+    if (iHazardA.distance != iHazardB.distance)
+        return iHazardA.distance < iHazardB.distance;
+
+    // Without a distance, lower in the frame means closer
+    return iHazardA.rect.br().y > iHazardB.rect.br().y;
+}
+
+FeatureStatus CollisionRisk::find_features(FrameFeatures& iFrameFeatures)
+{
+    iFrameFeatures.hazards.clear();
+    iFrameFeatures.corridor = std::pair<Track, Track>();
+    iFrameFeatures.corridorBounds = cv::Rect();
+
+    const Track& tLeft = iFrameFeatures.tracks.first;
+    const Track& tRight = iFrameFeatures.tracks.second;
+    if (tLeft.size() < 2 || tRight.size() < 2)
+        return FeatureStatus(REASON_MISSING_INPUT, "No tracks to build a corridor from");
+
+    // Widen the track to the envelope of the tram: the rails are a gauge
+    // apart on every row, which gives the scale of that row
+    Envelope tInside, tNear;
+    int tTop = std::max(tLeft.front().y, tRight.front().y);
+    int tBottom = std::min(tLeft.back().y, tRight.back().y);
+    int tStep = std::max(1, (int) reference(RISK_ROW_STEP));
+    for (int v = tTop; v <= tBottom; v = (v < tBottom) ? std::min(v + tStep, tBottom) : v + 1)
+    {
+        double tLeftColumn, tRightColumn;
+        if (!interpolate_polyline(tLeft, v, tLeftColumn) || !interpolate_polyline(tRight, v, tRightColumn))
+            continue;
+        double tCenter = (tLeftColumn + tRightColumn) / 2;
+        double tMeter = (tRightColumn - tLeftColumn) / RAIL_GAUGE;
+        double tInsideHalf = tMeter * (RISK_TRAM_WIDTH/2 + RISK_SWAY);
+        double tNearHalf = tInsideHalf + tMeter * RISK_NEAR;
+        tInside.left.push_back(cv::Point2f(tCenter - tInsideHalf, v));
+        tInside.right.push_back(cv::Point2f(tCenter + tInsideHalf, v));
+        tNear.left.push_back(cv::Point2f(tCenter - tNearHalf, v));
+        tNear.right.push_back(cv::Point2f(tCenter + tNearHalf, v));
+    }
+    if (tInside.left.size() < 2)
+        return FeatureStatus(REASON_MISSING_INPUT, "Tracks too short to build a corridor from");
+
+    // Save the corridor, and the region around it where detections matter
+    cv::Rect tBounds = cv::boundingRect(tNear.left) | cv::boundingRect(tNear.right);
+    int tMargin = reference(RISK_BOUNDS_MARGIN);
+    tBounds = cv::Rect(tBounds.x - tMargin, tBounds.y - tMargin, tBounds.width + 2*tMargin, tBounds.height + 2*tMargin);
+    iFrameFeatures.corridorBounds = tBounds & cv::Rect(0, 0, frame()->cols, frame()->rows);
+    for (size_t i = 0; i < tInside.left.size(); i++)
+    {
+        iFrameFeatures.corridor.first.push_back(tInside.left[i]);
+        iFrameFeatures.corridor.second.push_back(tInside.right[i]);
+    }
+
+    // Check everything we know about
+    if (iFrameFeatures.tram.width != 0)
+        assess(tInside, tNear, HAZARD_TRAM, 0, iFrameFeatures.tram, iFrameFeatures.tramDistance, iFrameFeatures.hazards);
+    for (size_t i = 0; i < iFrameFeatures.pedestrianObjects.size(); i++)
+    {
+        const TrackedObject& tObject = iFrameFeatures.pedestrianObjects[i];
+        assess(tInside, tNear, HAZARD_PEDESTRIAN, tObject.id, tObject.rect, tObject.distance, iFrameFeatures.hazards);
+    }
+    for (size_t i = 0; i < iFrameFeatures.vehicleObjects.size(); i++)
+    {
+        const TrackedObject& tObject = iFrameFeatures.vehicleObjects[i];
+        assess(tInside, tNear, HAZARD_VEHICLE, tObject.id, tObject.rect, tObject.distance, iFrameFeatures.hazards);
+    }
+    std::stable_sort(iFrameFeatures.hazards.begin(), iFrameFeatures.hazards.end(), hazard_before);
+
+    // Visualise the corridor and the hazards
+    if (debug().enabled())
+    {
+        for (size_t i = 0; i < tInside.left.size()-1; i++)
+        {
+            debug().line(tInside.left[i], tInside.left[i+1], cv::Scalar(0, 0, 255), 2);
+            debug().line(tInside.right[i], tInside.right[i+1], cv::Scalar(0, 0, 255), 2);
+            debug().line(tNear.left[i], tNear.left[i+1], cv::Scalar(0, 165, 255), 1);
+            debug().line(tNear.right[i], tNear.right[i+1], cv::Scalar(0, 165, 255), 1);
+        }
+        debug().rectangle(iFrameFeatures.corridorBounds.tl(), iFrameFeatures.corridorBounds.br(), cv::Scalar(255, 255, 0), 1);
+        for (size_t i = 0; i < iFrameFeatures.hazards.size(); i++)
+        {
+            const Hazard& tHazard = iFrameFeatures.hazards[i];
+            debug().rectangle(tHazard.rect.tl(), tHazard.rect.br(), tHazard.inside ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 165, 255), 3);
+        }
+    }
+    return FeatureStatus::found();
+}
+
+
+//
+// Feature detection
+//
+
+// Check whether a rectangle overlaps any piece of the envelope
+bool CollisionRisk::occupies(const Envelope& iEnvelope, const cv::Rect& iRect) const
+{
+    for (size_t i = 0; i < iEnvelope.left.size()-1; i++)
+    {
+        // Pieces are sorted by row, so skip the ones above the rectangle
+        // and stop after the ones below it
+        if (iEnvelope.left[i+1].y < iRect.y)
+            continue;
+        if (iEnvelope.left[i].y > iRect.y + iRect.height)
+            break;
+
+        cv::Point2f tQuad[4] = { iEnvelope.left[i], iEnvelope.right[i], iEnvelope.right[i+1], iEnvelope.left[i+1] };
+        if (intersect_quad_rect(tQuad, iRect))
+            return true;
+    }
+    return false;
+}
+
+void CollisionRisk::assess(const Envelope& iInside, const Envelope& iNear, HazardType iType, unsigned int iId, const cv::Rect& iRect, double iDistance, std::vector<Hazard>& oHazards) const
+{
+    if (!occupies(iNear, iRect))
+        return;
+
+    Hazard tHazard;
+    tHazard.type = iType;
+    tHazard.id = iId;
+    tHazard.rect = iRect;
+    tHazard.inside = occupies(iInside, iRect);
+    tHazard.distance = iDistance;
+    oHazards.push_back(tHazard);
+}
@@ -0,0 +1,48 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef COLLISIONRISK_H
+#define COLLISIONRISK_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include "component.h"
+#include "framefeatures.h"
+
+/*
+  The CollisionRisk component combines the other features. It sweeps the
+  tram along the detected tracks, which gives its dynamic envelope: the
+  corridor the tram is going to occupy. Every pedestrian, vehicle and tram
+  in or near that corridor is a hazard, and hazards are ordered by how
+  urgent they are (in the corridor before next to it, then nearest first).
+
+  The corridor is a strip of quadrilaterals, one per pair of sampled rows,
+  so that every piece is convex and can be tested against a detection with
+  the separating axis theorem, even when the tracks bend.
+  */
+class CollisionRisk : public Component
+{
+public:
+    // Construction and destruction
+    CollisionRisk(FrameContext* iContext);
+
+    // Component interface
+    void preprocess();
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
+
+private:
+    // Corridor boundaries, sampled on the same rows (top to bottom)
+    struct Envelope
+    {
+        std::vector<cv::Point2f> left, right;
+    };
+
+    // Feature detection
+    bool occupies(const Envelope& iEnvelope, const cv::Rect& iRect) const;
+    void assess(const Envelope& iInside, const Envelope& iNear, HazardType iType, unsigned int iId, const cv::Rect& iRect, double iDistance, std::vector<Hazard>& oHazards) const;
+};
+
+#endif // COLLISIONRISK_H
@@ -8,14 +8,36 @@
 
 // Includes
 #include "opencv/cv.h"
+#include <algorithm>
 #include "framefeatures.h"
-#include "featureexception.h"
+#include "featurestatus.h"
+#include "framecontext.h"
+#include "debugcanvas.h"
+
+// Resolution the pixel constants of the components were tuned on
+#define REFERENCE_WIDTH 1280
+#define REFERENCE_HEIGHT 720
 
 class Component
 {
 public:
-    Component(cv::Mat const* iFrame) : mFrame(iFrame)
+    /*
+      Every component works on a version of the input frame which is scaled
+      down to the passed amount of rows (or on the input frame itself when
+      passing 0). The features it saves are always expressed in coordinates
+      of the input frame though. The working frame is only computed once the
+      component actually uses it.
+
+      The detail factor lowers the working resolution some more, for when the
+      scheduler needs the component to run faster.
+      */
+    Component(FrameContext* iContext, int iWorkingHeight = 0, double iDetail = 1.0) : mContext(iContext), mFrame(0)
     {
+        int tInputRows = iContext->frame().rows;
+        if (iWorkingHeight <= 0 || iWorkingHeight >= tInputRows)
+            iWorkingHeight = tInputRows;
+        mWorkingHeight = std::max(1, cvRound(iWorkingHeight * iDetail));
+        mScale = (double) tInputRows / mWorkingHeight;
     }
 
     /*
@@ -28,26 +50,98 @@ public:
     /*
       This method actually detects the features in the (likely preprocessed)
       frame, and saves them in the passed FrameFeatures struct ref. The method
-      may depend on previously detected features. Throw an exception as soon as
-      something fails, don't just stop looking for features, as the main
-      application depends on this.
+      may depend on previously detected features. Return a status telling why
+      as soon as something fails, don't just stop looking for features, as the
+      main application depends on this. Not finding anything is routine, so
+      don't throw for it.
       */
-    virtual void find_features(FrameFeatures&) throw(FeatureException) = 0;
+    virtual FeatureStatus find_features(FrameFeatures&) = 0;
 
     /*
-      The current frame to be processed.
+      The current frame to be processed, at working resolution.
       */
 
     cv::Mat const* frame() const
     {
+        if (mFrame == 0)
+            mFrame = &mContext->level(mWorkingHeight);
         return mFrame;
     }
 
+    /*
+      The grayscale version of the current frame, shared with every other
+      component working at the same resolution.
+      */
+    cv::Mat const& frameGray() const
+    {
+        return mContext->gray(mWorkingHeight);
+    }
+
+    FrameContext* context() const
+    {
+        return mContext;
+    }
+
+    /*
+      Conversion between coordinates of the working and the input frame.
+      */
+
+    double scale() const
+    {
+        return mScale;
+    }
+
+    cv::Point toInput(const cv::Point& iPoint) const
+    {
+        return cv::Point(cvRound(iPoint.x * mScale), cvRound(iPoint.y * mScale));
+    }
+
+    cv::Rect toInput(const cv::Rect& iRect) const
+    {
+        return cv::Rect(toInput(iRect.tl()), toInput(iRect.br()));
+    }
+
+    cv::Point toWorking(const cv::Point& iPoint) const
+    {
+        return cv::Point(cvRound(iPoint.x / mScale), cvRound(iPoint.y / mScale));
+    }
 
-    virtual cv::Mat frameDebug() const = 0;
+    /*
+      Convert a length expressed in pixels of the reference resolution
+      to pixels of the working frame.
+      */
+    double reference(double iLength) const
+    {
+        return iLength * mWorkingHeight / REFERENCE_HEIGHT;
+    }
+
+    /*
+      Debug visualisation. Components record their overlay on the debug
+      canvas, which only does so when debugging has been enabled for that
+      specific component. The debug frame is rendered on request.
+      */
+
+    void setDebug(bool iEnabled)
+    {
+        mDebug.setEnabled(iEnabled);
+    }
+
+    DebugCanvas& debug()
+    {
+        return mDebug;
+    }
+
+    cv::Mat frameDebug() const
+    {
+        return mDebug.render();
+    }
 
 private:
-    cv::Mat const* mFrame;
+    DebugCanvas mDebug;
+    FrameContext* mContext;
+    int mWorkingHeight;
+    mutable cv::Mat const* mFrame;
+    double mScale;
 };
 
 #endif // COMPONENT_H
@@ -0,0 +1,161 @@
+//
+// Configuration
+//
+
+// Includes
+#include "debugcanvas.h"
+
+
+//
+// Construction and destruction
+//
+
+DebugCanvas::DebugCanvas() : mEnabled(false)
+{
+}
+
+
+//
+// Configuration
+//
+
+void DebugCanvas::setEnabled(bool iEnabled)
+{
+    mEnabled = iEnabled;
+    if (!mEnabled)
+    {
+        mCommands.clear();
+        mBackground = cv::Mat();
+    }
+}
+
+bool DebugCanvas::enabled() const
+{
+    return mEnabled;
+}
+
+// The background is only referenced, not copied, until rendering
+void DebugCanvas::setBackground(cv::Mat const& iBackground)
+{
+    if (mEnabled)
+        mBackground = iBackground;
+}
+
+
+//
+// Drawing
+//
+
+void DebugCanvas::line(cv::Point iPointA, cv::Point iPointB, cv::Scalar iColour, int iThickness, int iLineType)
+{
+    Command tCommand;
+    tCommand.shape = LINE;
+    tCommand.pointA = iPointA;
+    tCommand.pointB = iPointB;
+    tCommand.colour = iColour;
+    tCommand.thickness = iThickness;
+    tCommand.lineType = iLineType;
+    record(tCommand);
+}
+
+void DebugCanvas::rectangle(cv::Point iPointA, cv::Point iPointB, cv::Scalar iColour, int iThickness)
+{
+    Command tCommand;
+    tCommand.shape = RECTANGLE;
+    tCommand.pointA = iPointA;
+    tCommand.pointB = iPointB;
+    tCommand.colour = iColour;
+    tCommand.thickness = iThickness;
+    tCommand.lineType = 8;
+    record(tCommand);
+}
+
+void DebugCanvas::circle(cv::Point iCenter, int iRadius, cv::Scalar iColour, int iThickness)
+{
+    Command tCommand;
+    tCommand.shape = CIRCLE;
+    tCommand.pointA = iCenter;
+    tCommand.axes = cv::Size2f(iRadius, iRadius);
+    tCommand.colour = iColour;
+    tCommand.thickness = iThickness;
+    tCommand.lineType = 8;
+    record(tCommand);
+}
+
+void DebugCanvas::ellipse(cv::Point iCenter, cv::Size2f iAxes, double iAngle, cv::Scalar iColour, int iThickness, int iLineType)
+{
+    Command tCommand;
+    tCommand.shape = ELLIPSE;
+    tCommand.pointA = iCenter;
+    tCommand.axes = iAxes;
+    tCommand.angle = iAngle;
+    tCommand.colour = iColour;
+    tCommand.thickness = iThickness;
+    tCommand.lineType = iLineType;
+    record(tCommand);
+}
+
+void DebugCanvas::text(const std::string& iText, cv::Point iOrigin, cv::Scalar iColour)
+{
+    // Don't bother copying the text if it isn't going to be drawn
+    if (!mEnabled)
+        return;
+
+    Command tCommand;
+    tCommand.shape = TEXT;
+    tCommand.pointA = iOrigin;
+    tCommand.colour = iColour;
+    tCommand.thickness = 1;
+    tCommand.lineType = 8;
+    tCommand.text = iText;
+    record(tCommand);
+}
+
+void DebugCanvas::record(const Command& iCommand)
+{
+    if (mEnabled)
+        mCommands.push_back(iCommand);
+}
+
+
+//
+// Rasterisation
+//
+
+// Copy the background into a new BGR frame, and execute the recorded draw
+// commands on top of it.
+cv::Mat DebugCanvas::render() const
+{
+    cv::Mat oFrame;
+    if (mBackground.channels() == 1)
+        cv::cvtColor(mBackground, oFrame, CV_GRAY2BGR);
+    else
+        oFrame = mBackground.clone();
+    if (!oFrame.data)
+        return oFrame;
+
+    for (size_t i = 0; i < mCommands.size(); i++)
+    {
+        const Command& tCommand = mCommands[i];
+        switch (tCommand.shape)
+        {
+        case LINE:
+            cv::line(oFrame, tCommand.pointA, tCommand.pointB, tCommand.colour, tCommand.thickness, tCommand.lineType);
+            break;
+        case RECTANGLE:
+            cv::rectangle(oFrame, tCommand.pointA, tCommand.pointB, tCommand.colour, tCommand.thickness, tCommand.lineType);
+            break;
+        case CIRCLE:
+            cv::circle(oFrame, tCommand.pointA, cvRound(tCommand.axes.width), tCommand.colour, tCommand.thickness, tCommand.lineType);
+            break;
+        case ELLIPSE:
+            cv::ellipse(oFrame, tCommand.pointA, tCommand.axes, tCommand.angle, 0, 360, tCommand.colour, tCommand.thickness, tCommand.lineType);
+            break;
+        case TEXT:
+            cv::putText(oFrame, tCommand.text, tCommand.pointA, cv::FONT_HERSHEY_PLAIN, 1, tCommand.colour, tCommand.thickness, tCommand.lineType);
+            break;
+        }
+    }
+
+    return oFrame;
+}
@@ -0,0 +1,70 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef DEBUGCANVAS_H
+#define DEBUGCANVAS_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include <string>
+
+/*
+  The DebugCanvas records the overlay a component wants to draw on top of
+  its debug frame, as a list of draw commands. Nothing gets recorded unless
+  the canvas has been enabled, and the commands only get rasterised when
+  the debug frame is actually requested, so components don't need to copy
+  and draw on frames nobody is going to look at.
+  */
+class DebugCanvas
+{
+public:
+    // Construction and destruction
+    DebugCanvas();
+
+    // Configuration
+    void setEnabled(bool iEnabled);
+    bool enabled() const;
+    void setBackground(cv::Mat const& iBackground);
+
+    // Drawing
+    void line(cv::Point iPointA, cv::Point iPointB, cv::Scalar iColour, int iThickness = 1, int iLineType = 8);
+    void rectangle(cv::Point iPointA, cv::Point iPointB, cv::Scalar iColour, int iThickness = 1);
+    void circle(cv::Point iCenter, int iRadius, cv::Scalar iColour, int iThickness = 1);
+    void ellipse(cv::Point iCenter, cv::Size2f iAxes, double iAngle, cv::Scalar iColour, int iThickness = 1, int iLineType = 8);
+    void text(const std::string& iText, cv::Point iOrigin, cv::Scalar iColour);
+
+    // Rasterisation
+    cv::Mat render() const;
+
+private:
+    // Draw commands
+    enum Shape
+    {
+        LINE,
+        RECTANGLE,
+        CIRCLE,
+        ELLIPSE,
+        TEXT
+    };
+    struct Command
+    {
+        Shape shape;
+        cv::Point pointA, pointB;
+        cv::Size2f axes;
+        double angle;
+        cv::Scalar colour;
+        int thickness, lineType;
+        std::string text;
+    };
+    void record(const Command& iCommand);
+
+    // Member data
+    bool mEnabled;
+    cv::Mat mBackground;
+    std::vector<Command> mCommands;
+};
+
+#endif // DEBUGCANVAS_H
@@ -0,0 +1,90 @@
+//
+// Configuration
+//
+
+// Includes
+#include "featurepublisher.h"
+#include <QThread>
+
+
+//
+// Construction and destruction
+//
+
+FeaturePublisher::FeaturePublisher() : mLatest(0), mBack(1), mVersion(0)
+{
+    for (int i = 0; i < PUBLISHER_SLOTS; i++)
+        mVersions[i] = 0;
+}
+
+
+//
+// Publication
+//
+
+// Copy the features into a free slot, and make it the latest one
+void FeaturePublisher::publish(const FrameFeatures& iFeatures)
+{
+    mSlots[mBack] = iFeatures;
+    mVersions[mBack] = ++mVersion;
+    int tLatest = mBack;
+    mLatest.fetchAndStoreOrdered(tLatest);
+
+    // Pick the slot to fill next: anything but the latest one, which no
+    // reader holds (a reader only pins a slot after checking it's the
+    // latest one, so it backs off from this one while it's being filled)
+    for (;;)
+    {
+        for (int i = 1; i < PUBLISHER_SLOTS; i++)
+        {
+            int tSlot = (tLatest + i) % PUBLISHER_SLOTS;
+            if (mReaders[tSlot].fetchAndAddOrdered(0) == 0)
+            {
+                mBack = tSlot;
+                return;
+            }
+        }
+        QThread::yieldCurrentThread();
+    }
+}
+
+
+//
+// Snapshot
+//
+
+FeaturePublisher::Snapshot::Snapshot(FeaturePublisher& iPublisher) : mPublisher(iPublisher)
+{
+    // Pin the latest slot, and make sure it still is the latest one once
+    // pinned (otherwise the writer may have picked it to fill next)
+    for (;;)
+    {
+        mSlot = mPublisher.mLatest.fetchAndAddOrdered(0);
+        mPublisher.mReaders[mSlot].ref();
+        if (mPublisher.mLatest.fetchAndAddOrdered(0) == mSlot)
+            break;
+        mPublisher.mReaders[mSlot].deref();
+    }
+}
+
+FeaturePublisher::Snapshot::~Snapshot()
+{
+    mPublisher.mReaders[mSlot].deref();
+}
+
+const FrameFeatures& FeaturePublisher::Snapshot::operator*() const
+{
+    return mPublisher.mSlots[mSlot];
+}
+
+const FrameFeatures* FeaturePublisher::Snapshot::operator->() const
+{
+    return &mPublisher.mSlots[mSlot];
+}
+
+// Number of the publication, counting from 1 (0 if nothing has been
+// published yet)
+unsigned long FeaturePublisher::Snapshot::version() const
+{
+    return mPublisher.mVersions[mSlot];
+}
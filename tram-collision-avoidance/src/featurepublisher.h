@@ -0,0 +1,83 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef FEATUREPUBLISHER_H
+#define FEATUREPUBLISHER_H
+
+// Includes
+#include <QAtomicInt>
+#include "framefeatures.h"
+
+// Snapshots kept around: the one being written, the latest one, and room for
+// readers still holding older ones
+#define PUBLISHER_SLOTS 4
+
+/*
+  The FeaturePublisher hands the features of every processed frame from the
+  thread detecting them to any thread consuming them (the renderer, the
+  recorder, the alert output), without either side ever taking a lock.
+
+  The detection thread keeps working on its own FrameFeatures, and
+  publishes a copy of it once the frame is complete. Copies go into a small
+  set of slots: the writer only ever fills a slot which is neither the
+  latest one nor held by a reader, so a published snapshot never changes
+  while someone reads it. Readers hold on to a slot through a Snapshot,
+  which always pins the latest complete one. Every snapshot carries a
+  version, which goes up by one per publication, so a reader can tell
+  whether there's anything new.
+
+  There can only be one publishing thread, but any number of readers (as
+  long as less than PUBLISHER_SLOTS - 1 hold a snapshot at the same time,
+  otherwise publishing waits for one to be released).
+  */
+class FeaturePublisher
+{
+public:
+    // The latest complete features, which stay unchanged while held
+    class Snapshot
+    {
+    public:
+        // Construction and destruction
+        Snapshot(FeaturePublisher& iPublisher);
+        ~Snapshot();
+
+        // Access
+        const FrameFeatures& operator*() const;
+        const FrameFeatures* operator->() const;
+        unsigned long version() const;
+
+    private:
+        // Member data
+        FeaturePublisher& mPublisher;
+        int mSlot;
+
+        // Disable copying
+        Snapshot(const Snapshot&);
+        Snapshot& operator=(const Snapshot&);
+    };
+
+    // Construction and destruction
+    FeaturePublisher();
+
+    // Publication
+    void publish(const FrameFeatures& iFeatures);
+
+private:
+    // Member data
+    FrameFeatures mSlots[PUBLISHER_SLOTS];
+    unsigned long mVersions[PUBLISHER_SLOTS];
+    QAtomicInt mReaders[PUBLISHER_SLOTS];
+    QAtomicInt mLatest;
+
+    // Writer state
+    int mBack;
+    unsigned long mVersion;
+
+    // Disable copying
+    FeaturePublisher(const FeaturePublisher&);
+    FeaturePublisher& operator=(const FeaturePublisher&);
+};
+
+#endif // FEATUREPUBLISHER_H
@@ -0,0 +1,79 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef FEATURESTATUS_H
+#define FEATURESTATUS_H
+
+// Enumerations
+enum FeatureReason {
+    REASON_FOUND = 0,
+    REASON_NOT_FOUND,           // the scene doesn't contain the feature
+    REASON_MISSING_INPUT,       // a feature this one builds on is missing
+    REASON_REJECTED,            // something was found, but failed a sanity check
+    REASON_UNCALIBRATED,        // a model isn't ready to be used yet
+    REASON_NO_RESOURCE,         // detector data couldn't be loaded
+    REASON_COUNT
+};
+
+/*
+  The FeatureStatus tells how finding a feature went. Most frames simply
+  don't contain every feature, which is routine and shouldn't cost anything
+  more than returning: the status is a plain value, and its message is a
+  string literal, so reporting it neither allocates nor unwinds. A value
+  can be passed along for context (e.g. the best match which still wasn't
+  good enough).
+  */
+class FeatureStatus
+{
+public:
+    // Construction and destruction
+    FeatureStatus() : mReason(REASON_FOUND), mMessage(""), mValue(0)
+    {
+    }
+
+    FeatureStatus(FeatureReason iReason, const char* iMessage, double iValue = 0) : mReason(iReason), mMessage(iMessage), mValue(iValue)
+    {
+    }
+
+    static FeatureStatus found()
+    {
+        return FeatureStatus();
+    }
+
+    // Properties
+    bool ok() const
+    {
+        return mReason == REASON_FOUND;
+    }
+
+    FeatureReason reason() const
+    {
+        return mReason;
+    }
+
+    const char* message() const
+    {
+        return mMessage;
+    }
+
+    double value() const
+    {
+        return mValue;
+    }
+
+    static const char* name(FeatureReason iReason)
+    {
+        static const char* tNames[REASON_COUNT] = { "found", "not_found", "missing_input", "rejected", "uncalibrated", "no_resource" };
+        return tNames[iReason];
+    }
+
+private:
+    // Member data
+    FeatureReason mReason;
+    const char* mMessage;
+    double mValue;
+};
+
+#endif // FEATURESTATUS_H
@@ -0,0 +1,117 @@
+//
+// Configuration
+//
+
+// Includes
+#include "framearena.h"
+#include <cstdlib>
+#include <algorithm>
+#include <QThreadStorage>
+
+// Arena properties
+#define ARENA_BLOCK_SIZE (256*1024)     // initial size, in bytes
+#define ARENA_ALIGNMENT 16              // of every allocation, in bytes
+
+
+//
+// Construction and destruction
+//
+
+FrameArena::FrameArena() : mCurrent(0), mLeft(0), mUsed(0), mCapacity(0)
+{
+    grow(ARENA_BLOCK_SIZE);
+}
+
+FrameArena::~FrameArena()
+{
+    for (size_t i = 0; i < mBlocks.size(); i++)
+        free(mBlocks[i]);
+}
+
+
+//
+// Allocation
+//
+
+void* FrameArena::allocate(size_t iSize)
+{
+    iSize = (iSize + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+    if (iSize > mLeft)
+        grow(std::max(iSize, mSizes.back() * 2));
+
+    void* tPointer = mCurrent;
+    mCurrent += iSize;
+    mLeft -= iSize;
+    mUsed += iSize;
+    return tPointer;
+}
+
+// Release everything allocated since the last reset
+void FrameArena::reset()
+{
+    // Last frame didn't fit in one block, so replace the chain with a block
+    // which holds all of them
+    if (mBlocks.size() > 1)
+    {
+        for (size_t i = 0; i < mBlocks.size(); i++)
+            free(mBlocks[i]);
+        mBlocks.clear();
+        mSizes.clear();
+        size_t tCapacity = mCapacity;
+        mCapacity = 0;
+        grow(tCapacity);
+    }
+
+    mCurrent = mBlocks.back();
+    mLeft = mSizes.back();
+    mUsed = 0;
+}
+
+
+//
+// Statistics
+//
+
+// Bytes allocated since the last reset
+size_t FrameArena::used() const
+{
+    return mUsed;
+}
+
+size_t FrameArena::capacity() const
+{
+    return mCapacity;
+}
+
+
+//
+// Arena of the calling thread
+//
+
+static QThreadStorage<FrameArena*> gArenas;
+
+FrameArena& FrameArena::local()
+{
+    if (!gArenas.hasLocalData())
+        gArenas.setLocalData(new FrameArena());
+    return *gArenas.localData();
+}
+
+
+//
+// Auxiliary
+//
+
+// Chain on a new block (blocks start out aligned, as malloc() returns
+// memory suitable for any type)
+void FrameArena::grow(size_t iSize)
+{
+    char* tBlock = static_cast<char*>(malloc(iSize));
+    if (tBlock == 0)
+        throw std::bad_alloc();
+    mBlocks.push_back(tBlock);
+    mSizes.push_back(iSize);
+    mCurrent = tBlock;
+    mLeft = iSize;
+    mCapacity += iSize;
+}
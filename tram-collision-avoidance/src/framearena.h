@@ -0,0 +1,163 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+// Includes
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <list>
+
+/*
+  The FrameArena hands out memory for the temporaries of a single frame by
+  bumping a pointer through a block it owns. Nothing gets freed on its own:
+  the whole arena is reset at the end of the frame, which only rewinds the
+  pointer. When a frame needs more than the block holds, more blocks are
+  chained on, and at the next reset they get merged into one block large
+  enough for the whole frame, so a stream soon stops allocating altogether.
+
+  Every thread has its own arena, so allocating never locks. It is meant for
+  containers which live no longer than the find_features() call allocating
+  them, on the thread running the pipeline: the pipeline resets the arena of
+  its thread once the frame is done.
+  */
+class FrameArena
+{
+public:
+    // Construction and destruction
+    FrameArena();
+    ~FrameArena();
+
+    // Allocation
+    void* allocate(size_t iSize);
+    void reset();
+
+    // Statistics
+    size_t used() const;
+    size_t capacity() const;
+
+    // Arena of the calling thread
+    static FrameArena& local();
+
+private:
+    // Auxiliary
+    void grow(size_t iSize);
+
+    // Member data
+    std::vector<char*> mBlocks;
+    std::vector<size_t> mSizes;
+    char* mCurrent;
+    size_t mLeft, mUsed, mCapacity;
+
+    // Disable copying
+    FrameArena(const FrameArena&);
+    FrameArena& operator=(const FrameArena&);
+};
+
+/*
+  Standard allocator drawing from a FrameArena (the one of the constructing
+  thread by default), so standard containers can be put in the arena.
+  Deallocating does nothing, the memory only comes back when the arena gets
+  reset.
+  */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    // Type definitions
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    // Construction and destruction
+    ArenaAllocator() : mArena(&FrameArena::local()) {}
+    explicit ArenaAllocator(FrameArena* iArena) : mArena(iArena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& iOther) : mArena(iOther.arena()) {}
+
+    // Allocation
+    pointer allocate(size_type iCount, const void* = 0)
+    {
+        return static_cast<pointer>(mArena->allocate(iCount * sizeof(T)));
+    }
+
+    void deallocate(pointer, size_type)
+    {
+    }
+
+    size_type max_size() const
+    {
+        return size_t(-1) / sizeof(T);
+    }
+
+    // Construction
+    void construct(pointer iPointer, const T& iValue)
+    {
+        new ((void*) iPointer) T(iValue);
+    }
+
+    void destroy(pointer iPointer)
+    {
+        iPointer->~T();
+    }
+
+    // Properties
+    pointer address(reference iValue) const
+    {
+        return &iValue;
+    }
+
+    const_pointer address(const_reference iValue) const
+    {
+        return &iValue;
+    }
+
+    FrameArena* arena() const
+    {
+        return mArena;
+    }
+
+private:
+    FrameArena* mArena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& iA, const ArenaAllocator<U>& iB)
+{
+    return iA.arena() == iB.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& iA, const ArenaAllocator<U>& iB)
+{
+    return iA.arena() != iB.arena();
+}
+
+// Containers in the arena of the calling thread
+template <typename T>
+struct ArenaVector
+{
+    typedef std::vector<T, ArenaAllocator<T> > type;
+};
+
+template <typename T>
+struct ArenaList
+{
+    typedef std::list<T, ArenaAllocator<T> > type;
+};
+
+#endif // FRAMEARENA_H
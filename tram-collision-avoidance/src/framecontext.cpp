@@ -0,0 +1,130 @@
+//
+// Configuration
+//
+
+// Includes
+#include "framecontext.h"
+#include <QMutexLocker>
+#include "bufferpool.h"
+
+
+//
+// Construction and destruction
+//
+
+FrameContext::FrameContext(cv::Mat const& iFrame) : mFrame(iFrame)
+{
+}
+
+
+//
+// Pyramid
+//
+
+cv::Mat const& FrameContext::frame() const
+{
+    return mFrame;
+}
+
+// Fetch the frame scaled down to the requested amount of rows. Frames are
+// never scaled up, so requesting 0 rows (or more rows than the input frame
+// has) returns the input frame itself.
+cv::Mat const& FrameContext::level(int iHeight)
+{
+    iHeight = normalize(iHeight);
+    if (iHeight == mFrame.rows)
+        return mFrame;
+
+    QMutexLocker tLocker(&mMutex);
+    return buildLevel(iHeight);
+}
+
+cv::Mat const& FrameContext::half()
+{
+    return level(mFrame.rows / 2);
+}
+
+cv::Mat const& FrameContext::quarter()
+{
+    return level(mFrame.rows / 4);
+}
+
+
+//
+// Derived images
+//
+
+cv::Mat const& FrameContext::gray(int iHeight)
+{
+    QMutexLocker tLocker(&mMutex);
+    return buildGray(normalize(iHeight));
+}
+
+cv::Mat const& FrameContext::integral(int iHeight)
+{
+    iHeight = normalize(iHeight);
+
+    QMutexLocker tLocker(&mMutex);
+    std::map<int, cv::Mat>::iterator tIntegral = mIntegrals.find(iHeight);
+    if (tIntegral != mIntegrals.end())
+        return tIntegral->second;
+
+    cv::Mat& oIntegral = mIntegrals[iHeight];
+    oIntegral.allocator = BufferPool::instance();
+    cv::integral(buildGray(iHeight), oIntegral, CV_32S);
+    return oIntegral;
+}
+
+
+//
+// Auxiliary
+//
+
+int FrameContext::normalize(int iHeight) const
+{
+    if (iHeight <= 0 || iHeight >= mFrame.rows)
+        return mFrame.rows;
+    return iHeight;
+}
+
+// These helpers expect the mutex to be locked, and a normalized height
+cv::Mat const& FrameContext::buildLevel(int iHeight)
+{
+    if (iHeight == mFrame.rows)
+        return mFrame;
+
+    std::map<int, cv::Mat>::iterator tLevel = mLevels.find(iHeight);
+    if (tLevel != mLevels.end())
+        return tLevel->second;
+
+    // Downscale from the smallest level which is still larger than the
+    // requested one, rather than starting from the input frame every time
+    cv::Mat tSource = mFrame;
+    tLevel = mLevels.upper_bound(iHeight);
+    if (tLevel != mLevels.end())
+        tSource = tLevel->second;
+
+    cv::Mat& oLevel = mLevels[iHeight];
+    oLevel.allocator = BufferPool::instance();
+    int tWidth = cvRound((double) mFrame.cols * iHeight / mFrame.rows);
+    cv::resize(tSource, oLevel, cv::Size(tWidth, iHeight), 0, 0, cv::INTER_AREA);
+    return oLevel;
+}
+
+cv::Mat const& FrameContext::buildGray(int iHeight)
+{
+    std::map<int, cv::Mat>::iterator tGray = mGrays.find(iHeight);
+    if (tGray != mGrays.end())
+        return tGray->second;
+
+    cv::Mat const& tLevel = buildLevel(iHeight);
+    cv::Mat& oGray = mGrays[iHeight];
+    if (tLevel.channels() == 1)
+        oGray = tLevel;
+    else
+    {
+        oGray.allocator = BufferPool::instance();
+        cv::cvtColor(tLevel, oGray, CV_BGR2GRAY);
+    }
+    return oGray;
+}
@@ -0,0 +1,54 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef FRAMECONTEXT_H
+#define FRAMECONTEXT_H
+
+// Includes
+#include "opencv/cv.h"
+#include <map>
+#include <QMutex>
+
+/*
+  The FrameContext wraps a single input frame, and hands out downscaled
+  versions of it to the components. Every component declares the amount of
+  rows it needs to work on, and the matching pyramid level is computed only
+  once per frame, no matter how many components request it. The same goes
+  for the grayscale conversion and the integral image of every level.
+
+  All returned images are shared between the components, and should be
+  treated as read-only: clone them before drawing or thresholding in place.
+  Their buffers come from the BufferPool, so they get recycled for the
+  next frame.
+  */
+class FrameContext
+{
+public:
+    // Construction and destruction
+    FrameContext(cv::Mat const& iFrame);
+
+    // Pyramid
+    cv::Mat const& frame() const;
+    cv::Mat const& level(int iHeight);
+    cv::Mat const& half();
+    cv::Mat const& quarter();
+
+    // Derived images
+    cv::Mat const& gray(int iHeight = 0);
+    cv::Mat const& integral(int iHeight = 0);
+
+private:
+    // Auxiliary
+    int normalize(int iHeight) const;
+    cv::Mat const& buildLevel(int iHeight);
+    cv::Mat const& buildGray(int iHeight);
+
+    // Member data
+    cv::Mat mFrame;
+    std::map<int, cv::Mat> mLevels, mGrays, mIntegrals;
+    QMutex mMutex;
+};
+
+#endif // FRAMECONTEXT_H
@@ -9,23 +9,103 @@
 // Includes
 #include "opencv/cv.h"
 #include <vector>
-#include <QList>
-#include <QPair>
+#include <utility>
 
 // Type definitions
-typedef QList<cv::Point> Track;
+typedef std::vector<cv::Point> Track;
+
+// When a feature was last detected, and how much it can still be trusted
+struct FeatureAge
+{
+    FeatureAge() : frame(0), timestamp(0), confidence(0)
+    {
+    }
+
+    void update(unsigned long iFrame, double iTimestamp, double iConfidence)
+    {
+        frame = iFrame;
+        timestamp = iTimestamp;
+        confidence = iConfidence;
+    }
+
+    unsigned long frame;        // video frame the feature was detected in
+    double timestamp;           // position in the video, in milliseconds
+    double confidence;          // 1 when detected, decays while not refreshed
+};
+
+// An object followed across frames
+struct TrackedObject
+{
+    TrackedObject() : id(0), confirmed(false), distance(0)
+    {
+    }
+
+    unsigned int id;
+    cv::Rect rect;              // predicted position in the current frame
+    cv::Point2f velocity;       // in pixels per video frame
+    bool confirmed;
+    double distance;            // over the ground, in meters (0 if unknown)
+};
+
+// Motion of the tram ahead, filtered across frames
+struct TramMotion
+{
+    TramMotion() : valid(false), timestamp(0), width(0), widthRate(0), distance(0), distanceRate(0)
+    {
+    }
+
+    bool valid;
+    double timestamp;           // of the last measurement, in milliseconds
+    double width, widthRate;    // in pixels, and pixels per second
+    double distance, distanceRate;  // in meters, and meters per second
+};
+
+// Something in or near the path of the tram
+enum HazardType {
+    HAZARD_TRAM,
+    HAZARD_PEDESTRIAN,
+    HAZARD_VEHICLE
+};
+struct Hazard
+{
+    HazardType type;
+    unsigned int id;            // of the tracked object (0 for the tram)
+    cv::Rect rect;
+    bool inside;                // in the corridor, rather than next to it
+    double distance;            // in meters (0 if unknown)
+};
 
 struct FrameFeatures
 {
-    QPair<Track, Track> tracks;
+    FrameFeatures() : frame(0), timestamp(0), minValue(0), maxValue(0), tramScale(1), tramDistance(0), closingSpeed(0), timeToCollision(0)
+    {
+    }
+
+    // Current frame
+    unsigned long frame;
+    double timestamp;
+
+    std::pair<Track, Track> tracks;
     std::vector<cv::Rect> pedestrians;
     std::vector<cv::Rect> vehicles;
+    std::vector<TrackedObject> pedestrianObjects, vehicleObjects;
+    FeatureAge tracksAge, tramAge, pedestriansAge, vehiclesAge;
 
     // TramDetection
     cv::Rect tram;
     cv::Point location;
     cv::Point tramHalfX, trackHalfX;
-    double minValue, maxValue, tramDistance;
+    double minValue, maxValue, tramScale, tramDistance;
+
+    // TimeToCollision
+    TramMotion tramMotion;
+    double closingSpeed;        // in meters per second
+    double timeToCollision;     // in seconds, 0 if not closing in
+
+    // CollisionRisk
+    std::pair<Track, Track> corridor;   // boundaries of the dynamic envelope
+    cv::Rect corridorBounds;        // region worth running detectors on
+    std::vector<Hazard> hazards;    // most urgent first
     //cv::Point leftUpperLeft, leftLowerRight, rightUpperRight, rightLowerLeft;
 };
 
@@ -0,0 +1,272 @@
+//
+// Configuration
+//
+
+// Includes
+#include "framegrabber.h"
+#include <QMutexLocker>
+#include <QString>
+#include <QRegExp>
+#include <QFileInfo>
+#include "bufferpool.h"
+#include "logger.h"
+
+// Capture properties
+#define GRABBER_DEFAULT_FPS 25
+#define GRABBER_MAX_FAILURES 50     // failed grabs in a row before a live source is considered gone
+#define GRABBER_RETRY_DELAY 10      // in milliseconds
+#define GRABBER_SHARED_POLL 1       // between checks of a shared ring for a new frame, in milliseconds
+
+
+//
+// Construction and destruction
+//
+
+FrameGrabber::FrameGrabber() : mShared(0), mOpen(false), mFile(false), mFps(GRABBER_DEFAULT_FPS), mStopping(false), mFresh(false), mFinished(false), mCaptured(0), mDropped(0)
+{
+    mClock.start();
+}
+
+FrameGrabber::~FrameGrabber()
+{
+    close();
+}
+
+
+//
+// Capture
+//
+
+// Open a source, which is either a device ("/dev/video0", or just its
+// number), a stream URL, a ring of frames in shared memory ("shm://NAME"),
+// or a file to replay as if it were live
+bool FrameGrabber::open(const std::string& iSource)
+{
+    close();
+
+    QString tSource = QString::fromStdString(iSource);
+    QRegExp tDevice("^(/dev/video)?(\\d+)$");
+    if (tSource.startsWith("shm://"))
+    {
+        mShared = SharedFrameRing::open("/" + iSource.substr(6));
+        if (mShared == 0)
+            return false;
+        mFps = mShared->fps();
+        if (mFps <= 0 || mFps > 1000)
+            mFps = GRABBER_DEFAULT_FPS;
+        mSize = mShared->size();
+        mFile = false;
+        mCaptured = 0;
+        mOpen = true;
+        return true;
+    }
+    else if (tDevice.exactMatch(tSource))
+    {
+        mCapture.open(tDevice.cap(2).toInt());
+        mFile = false;
+    }
+    else
+    {
+        mCapture.open(iSource);
+        mFile = !tSource.contains("://") && QFileInfo(tSource).isFile();
+    }
+    if (!mCapture.isOpened())
+        return false;
+
+    // Not every source reports its properties
+    mFps = mCapture.get(CV_CAP_PROP_FPS);
+    if (mFps <= 0 || mFps > 1000)
+        mFps = GRABBER_DEFAULT_FPS;
+    mSize = cv::Size(mCapture.get(CV_CAP_PROP_FRAME_WIDTH), mCapture.get(CV_CAP_PROP_FRAME_HEIGHT));
+
+    mFrame = cv::Mat();
+    mFresh = false;
+    mFinished = false;
+    mCaptured = 0;
+    mDropped = 0;
+    mStopping = false;
+    mOpen = true;
+    start();
+    return true;
+}
+
+void FrameGrabber::close()
+{
+    if (!mOpen)
+        return;
+
+    if (mShared != 0)
+    {
+        mShared->close();
+        mShared = 0;
+        mOpen = false;
+        return;
+    }
+    mStopping = true;
+    wait();
+    mCapture.release();
+    mOpen = false;
+}
+
+bool FrameGrabber::isOpen() const
+{
+    return mOpen;
+}
+
+// Whether the source ran dry, and its last frame has been fetched
+bool FrameGrabber::finished()
+{
+    if (mShared != 0)
+        return mShared->finished();
+    QMutexLocker tLocker(&mMutex);
+    return mFinished && !mFresh;
+}
+
+// Fetch the newest frame, if it hasn't been fetched before (waiting for it
+// up to the given amount of milliseconds)
+bool FrameGrabber::latest(cv::Mat& oFrame, Stamp& oStamp, unsigned long iTimeout)
+{
+    if (mShared != 0)
+    {
+        // The producer can't wake us up, so poll the ring
+        qint64 tDeadline = mClock.elapsed() + iTimeout;
+        uint64_t tSequence, tWritten;
+        double tPosition;
+        while (!mShared->latest(oFrame, tSequence, tPosition, tWritten))
+        {
+            if (mShared->finished() || mClock.elapsed() >= tDeadline)
+                return false;
+            msleep(GRABBER_SHARED_POLL);
+        }
+
+        // Both processes stamp frames on the monotonic clock
+        oStamp.sequence = tSequence;
+        oStamp.position = tPosition;
+        oStamp.captured = (qint64) (tWritten / 1000) - mClock.msecsSinceReference();
+        QMutexLocker tLocker(&mMutex);
+        mCaptured++;
+        return true;
+    }
+
+    QMutexLocker tLocker(&mMutex);
+    if (!mFresh && !mFinished && iTimeout > 0)
+        mNewFrame.wait(&mMutex, iTimeout);
+    if (!mFresh)
+        return false;
+
+    oFrame = mFrame;
+    oStamp = mStamp;
+    mFrame = cv::Mat();
+    mFresh = false;
+    return true;
+}
+
+// Current time on the clock the frames are stamped with, in milliseconds
+qint64 FrameGrabber::elapsed() const
+{
+    return mClock.elapsed();
+}
+
+
+//
+// Properties
+//
+
+double FrameGrabber::fps() const
+{
+    return mFps;
+}
+
+cv::Size FrameGrabber::size() const
+{
+    return mSize;
+}
+
+
+//
+// Statistics
+//
+
+unsigned long FrameGrabber::captured()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mCaptured;
+}
+
+// Frames which got replaced by a newer one before being fetched
+unsigned long FrameGrabber::dropped()
+{
+    if (mShared != 0)
+        return mShared->dropped();
+    QMutexLocker tLocker(&mMutex);
+    return mDropped;
+}
+
+
+//
+// Capture thread
+//
+
+void FrameGrabber::run()
+{
+    qint64 tStart = mClock.elapsed();
+    unsigned long tSequence = 0;
+    int tFailures = 0;
+    cv::Mat tDecoded;
+    while (!mStopping)
+    {
+        // Files would be read as fast as they decode, so pace them
+        if (mFile)
+        {
+            qint64 tDue = tStart + (qint64) (tSequence * 1000 / mFps);
+            qint64 tNow = mClock.elapsed();
+            if (tDue > tNow)
+                msleep(tDue - tNow);
+        }
+
+        if (!mCapture.grab())
+        {
+            // Live sources can hiccup, files can't
+            if (mFile)
+                break;
+            if (++tFailures > GRABBER_MAX_FAILURES)
+            {
+                Logger::instance().log(LOG_WARNING, LOG_CAPTURE, "giving up on the source after {} failed grabs", tFailures - 1);
+                break;
+            }
+            msleep(GRABBER_RETRY_DELAY);
+            continue;
+        }
+        tFailures = 0;
+        qint64 tCaptured = mClock.elapsed();
+
+        // The capture decodes into a buffer of its own, which it overwrites
+        // with the next frame, so hand out a copy (the previous frame may
+        // still be in use). The copy recycles the buffers of frames which
+        // have been let go; retrieving into it directly wouldn't, as the
+        // capture replaces the matrix, allocator and all.
+        if (!mCapture.retrieve(tDecoded) || !tDecoded.data)
+            continue;
+        cv::Mat tFrame;
+        tFrame.allocator = BufferPool::instance();
+        tDecoded.copyTo(tFrame);
+
+        Stamp tStamp;
+        tStamp.sequence = tSequence++;
+        tStamp.position = mFile ? tStamp.sequence * 1000 / mFps : (double) (tCaptured - tStart);
+        tStamp.captured = tCaptured;
+
+        QMutexLocker tLocker(&mMutex);
+        if (mFresh)
+            mDropped++;
+        mFrame = tFrame;
+        mStamp = tStamp;
+        mFresh = true;
+        mCaptured++;
+        mNewFrame.wakeAll();
+    }
+
+    QMutexLocker tLocker(&mMutex);
+    mFinished = true;
+    mNewFrame.wakeAll();
+}
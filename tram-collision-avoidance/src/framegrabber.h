@@ -0,0 +1,88 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef FRAMEGRABBER_H
+#define FRAMEGRABBER_H
+
+// Includes
+#include "opencv/cv.h"
+#include "highgui.h"
+#include <string>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include "sharedframering.h"
+
+/*
+  The FrameGrabber captures a live source (a V4L2 device, or a network
+  stream) on its own thread. Only the newest frame is kept: whenever the
+  processing loop falls behind, older frames get overwritten, so it never
+  works on a frame which has been waiting in a queue. Capturing continuously
+  also keeps the buffers of the driver or the stream from filling up.
+
+  Every frame is stamped with its capture time, so the processing loop can
+  tell how old its results are. A video file opened as a live source gets
+  paced at its frame rate, which makes it behave like a camera.
+
+  A source named "shm://NAME" is a ring of frames in shared memory, decoded
+  by another process. Those frames don't need a thread to capture them:
+  fetching one simply wraps the newest slot of the ring, without a copy.
+  */
+class FrameGrabber : public QThread
+{
+public:
+    // When and where a frame was captured
+    struct Stamp
+    {
+        unsigned long sequence;     // frames captured before this one
+        double position;            // since the start of the source, in milliseconds
+        qint64 captured;            // on the clock of the grabber, in milliseconds
+    };
+
+    // Construction and destruction
+    FrameGrabber();
+    ~FrameGrabber();
+
+    // Capture
+    bool open(const std::string& iSource);
+    void close();
+    bool isOpen() const;
+    bool finished();
+    bool latest(cv::Mat& oFrame, Stamp& oStamp, unsigned long iTimeout = 0);
+    qint64 elapsed() const;
+
+    // Properties
+    double fps() const;
+    cv::Size size() const;
+
+    // Statistics
+    unsigned long captured();
+    unsigned long dropped();
+
+protected:
+    // Capture thread
+    void run();
+
+private:
+    // Member data
+    cv::VideoCapture mCapture;
+    SharedFrameRing* mShared;
+    bool mOpen, mFile;
+    double mFps;
+    cv::Size mSize;
+    QElapsedTimer mClock;
+    volatile bool mStopping;
+
+    // Latest frame
+    QMutex mMutex;
+    QWaitCondition mNewFrame;
+    cv::Mat mFrame;
+    Stamp mStamp;
+    bool mFresh, mFinished;
+    unsigned long mCaptured, mDropped;
+};
+
+#endif // FRAMEGRABBER_H
@@ -5,16 +5,33 @@
 // Includes
 #include "glwidget.h"
 
+// Not every GL header exposes the post-1.1 enumerants
+#ifndef GL_BGR
+#define GL_BGR 0x80E0
+#endif
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
 
 //
 // Construction and destruction
 //
 
-GLWidget::GLWidget() : QGLWidget(QGLFormat(QGL::SampleBuffers))
+GLWidget::GLWidget() : QGLWidget(QGLFormat(QGL::SampleBuffers)), mTexture(0), mTextureChannels(0)
 {
     setMinimumSize(320, 240);
 }
 
+GLWidget::~GLWidget()
+{
+    if (mTexture != 0)
+    {
+        makeCurrent();
+        glDeleteTextures(1, &mTexture);
+    }
+}
+
 
 //
 // Image loading
@@ -23,6 +40,14 @@ GLWidget::GLWidget() : QGLWidget(QGLFormat(QGL::SampleBuffers))
 void GLWidget::initializeGL()
 {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glDisable(GL_DEPTH_TEST);
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
 
@@ -30,50 +55,77 @@ void GLWidget::initializeGL()
 // OpenGL functionality
 //
 
+// Draw the texture over the full viewport. The scaling is done by the
+// texture sampler, and image row 0 maps to the top of the widget.
 void GLWidget::paintGL()
 {
-    glClear (GL_COLOR_BUFFER_BIT);
-    glClearColor (0.0,0.0,0.0,1.0);
-    if (!qframe.isNull())
-    {
-        qframe = qframe.scaled(this->size(), Qt::IgnoreAspectRatio,Qt::SmoothTransformation);
-        // you can use glDrawPixels directly
-        // glDrawPixels(qframe.width(),qframe.height(), GL_RGBA, GL_UNSIGNED_BYTE, qframe.bits());
-        // or do 2D texture mapping
-        glDisable(GL_DEPTH_TEST);
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
-        gluOrtho2D(0,qframe.width(),qframe.height(),0);
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
-        glEnable(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexImage2D( GL_TEXTURE_2D, 0, 4, qframe.width(), qframe.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, qframe.bits() );
-        glBegin(GL_QUADS);
-        glTexCoord2f(0,0); glVertex2f(0,qframe.height());
-        glTexCoord2f(0,1); glVertex2f(0,0);
-        glTexCoord2f(1,1); glVertex2f(qframe.width(),0);
-        glTexCoord2f(1,0); glVertex2f(qframe.width(),qframe.height());
-        glEnd();
-        glDisable(GL_TEXTURE_2D);
-
-        glFlush();
-    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (mTextureSize.area() == 0)
+        return;
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, 1, 1, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(0, 0);
+    glTexCoord2f(1, 0); glVertex2f(1, 0);
+    glTexCoord2f(1, 1); glVertex2f(1, 1);
+    glTexCoord2f(0, 1); glVertex2f(0, 1);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
 }
 
 void GLWidget::resizeGL(int w, int h)
 {
     glViewport (0, 0, (GLsizei) w, (GLsizei) h);
-    glMatrixMode (GL_PROJECTION);
-    glLoadIdentity ();
-    gluPerspective (60, (GLfloat)w / (GLfloat)h, 1.0, 100.0);
-    glMatrixMode (GL_MODELVIEW);
 }
 
 void GLWidget::sendImage(cv::Mat* img)
 {
-    qframe = QImage((const unsigned char*)(img->data), img->cols, img->rows, img->step, QImage::Format_RGB888).rgbSwapped();
-    qframe = QGLWidget::convertToGLFormat(qframe);
+    // Upload straight away, as the frame data might not outlive this call
+    makeCurrent();
+    uploadImage(*img);
     this->updateGL();
 }
+
+// Stream the pixels of the image into the persistent texture. The texture
+// storage is only (re)allocated when the frame geometry changes, and the BGR
+// data is handed to GL as-is, without any intermediate conversion.
+void GLWidget::uploadImage(const cv::Mat& iImage)
+{
+    if (mTexture == 0 || !iImage.data || iImage.depth() != CV_8U)
+        return;
+
+    GLenum tFormat;
+    switch (iImage.channels())
+    {
+    case 1:
+        tFormat = GL_LUMINANCE;
+        break;
+    case 3:
+        tFormat = GL_BGR;
+        break;
+    default:
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, iImage.step / iImage.elemSize());
+    if (iImage.size() != mTextureSize || iImage.channels() != mTextureChannels)
+    {
+        mTextureSize = iImage.size();
+        mTextureChannels = iImage.channels();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, iImage.cols, iImage.rows, 0, tFormat, GL_UNSIGNED_BYTE, iImage.data);
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, iImage.cols, iImage.rows, tFormat, GL_UNSIGNED_BYTE, iImage.data);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
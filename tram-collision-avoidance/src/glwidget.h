@@ -19,6 +19,7 @@ class GLWidget : public QGLWidget
 public:
     // Construction and destruction
     GLWidget();
+    ~GLWidget();
 
     // Image loading
     void sendImage(cv::Mat *img);
@@ -29,7 +30,12 @@ protected:
     void paintGL();
     void resizeGL(int width, int height);
 private:
-    QImage qframe;
+    void uploadImage(const cv::Mat& iImage);
+
+    // Persistent texture, kept between repaints
+    GLuint mTexture;
+    cv::Size mTextureSize;
+    int mTextureChannels;
 };
 
 #endif // GLWIDGET_H
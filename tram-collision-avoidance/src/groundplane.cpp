@@ -0,0 +1,220 @@
+//
+// Configuration
+//
+
+// Includes
+#include "groundplane.h"
+#include "auxiliary.h"
+#include <algorithm>
+#include <cmath>
+
+// Calibration properties
+#define GROUND_CAMERA_FOV 60.0          // horizontal field of view, in degrees
+#define GROUND_CALIBRATION_FRAMES 25    // frames with tracks to calibrate on
+#define GROUND_CALIBRATION_ROWS 48      // rows sampled per frame
+#define GROUND_HEIGHT_MIN 0.5           // sane camera heights, in meters
+#define GROUND_HEIGHT_MAX 10.0
+
+
+//
+// Construction and destruction
+//
+
+GroundPlane::GroundPlane() : mCalibrated(false), mFocal(0), mHeight(0), mPitch(0)
+{
+    calibrate();
+}
+
+
+//
+// Calibration
+//
+
+// Start collecting rail observations. The previous calibration stays in
+// use until the new one is complete.
+void GroundPlane::calibrate()
+{
+    mCalibrating = true;
+    mFrames = 0;
+    mRows.clear();
+    mWidths.clear();
+}
+
+bool GroundPlane::calibrating() const
+{
+    return mCalibrating;
+}
+
+bool GroundPlane::calibrated() const
+{
+    return mCalibrated;
+}
+
+// Frames observed, in percent of what the calibration needs
+int GroundPlane::progress() const
+{
+    return 100 * mFrames / GROUND_CALIBRATION_FRAMES;
+}
+
+// Sample the distance between both rails (left first) on a set of rows
+void GroundPlane::observe(const std::pair<Track, Track>& iTracks, cv::Size iFrameSize)
+{
+    if (!mCalibrating || iTracks.first.size() < 2 || iTracks.second.size() < 2)
+        return;
+    if (iFrameSize != mSize)
+    {
+        mSize = iFrameSize;
+        mCalibrated = false;
+        calibrate();
+    }
+
+    int tTop = std::max(iTracks.first.front().y, iTracks.second.front().y);
+    int tBottom = std::min(iTracks.first.back().y, iTracks.second.back().y);
+    if (tBottom <= tTop)
+        return;
+    int tStep = std::max(1, (tBottom - tTop) / GROUND_CALIBRATION_ROWS);
+    for (int v = tTop; v <= tBottom; v += tStep)
+    {
+        double tLeft, tRight;
+        if (interpolate_polyline(iTracks.first, v, tLeft) && interpolate_polyline(iTracks.second, v, tRight) && tRight > tLeft)
+        {
+            mRows.push_back(v);
+            mWidths.push_back(tRight - tLeft);
+        }
+    }
+
+    if (++mFrames >= GROUND_CALIBRATION_FRAMES)
+    {
+        if (fit())
+            mCalibrating = false;
+        else
+            calibrate();
+    }
+}
+
+// Height of the camera above the ground, in meters
+double GroundPlane::height() const
+{
+    return mHeight;
+}
+
+// Downwards pitch of the camera, in radians
+double GroundPlane::pitch() const
+{
+    return mPitch;
+}
+
+// Homography from image coordinates to ground coordinates (lateral offset
+// and depth, in meters)
+const cv::Mat& GroundPlane::homography() const
+{
+    return mHomography;
+}
+
+
+//
+// Mapping
+//
+
+// Project an image point onto the ground. Fails above the horizon.
+bool GroundPlane::toGround(cv::Point iPoint, cv::Point2d& oGround) const
+{
+    if (!mCalibrated || iPoint.y < 0 || iPoint.y >= (int) mDepth.size() || mDepth[iPoint.y] <= 0)
+        return false;
+    oGround.x = (iPoint.x - mSize.width/2.0) * mLateral[iPoint.y];
+    oGround.y = mDepth[iPoint.y];
+    return true;
+}
+
+// Distance over the ground to an image point, in meters (0 if unknown)
+double GroundPlane::distance(cv::Point iPoint) const
+{
+    cv::Point2d tGround;
+    if (!toGround(iPoint, tGround))
+        return 0;
+    return sqrt(tGround.x * tGround.x + tGround.y * tGround.y);
+}
+
+// Image row at a given depth (-1 if beyond the horizon)
+int GroundPlane::row(double iDepth) const
+{
+    for (int v = (int) mDepth.size() - 1; v >= 0; v--)
+    {
+        if (mDepth[v] <= 0)
+            break;
+        if (mDepth[v] >= iDepth)
+            return v;
+    }
+    return -1;
+}
+
+
+//
+// Auxiliary
+//
+
+// Fit the rail width w = k*(v - v0) through all observations, and derive the
+// camera model from it
+bool GroundPlane::fit()
+{
+    if (mRows.size() < 2)
+        return false;
+
+    // Least squares line through (v, w)
+    double tN = mRows.size(), tSv = 0, tSw = 0, tSvv = 0, tSvw = 0;
+    for (size_t i = 0; i < mRows.size(); i++)
+    {
+        tSv += mRows[i];
+        tSw += mWidths[i];
+        tSvv += mRows[i] * mRows[i];
+        tSvw += mRows[i] * mWidths[i];
+    }
+    double tDenominator = tN * tSvv - tSv * tSv;
+    if (tDenominator <= 0)
+        return false;
+    double k = (tN * tSvw - tSv * tSw) / tDenominator;
+    if (k <= 0)
+        return false;
+    double tHorizon = -((tSw - k * tSv) / tN) / k;
+    if (tHorizon >= mSize.height)
+        return false;
+
+    // Camera model, with the principal point in the center of the frame
+    double cx = mSize.width / 2.0, cy = mSize.height / 2.0;
+    double tFocal = cx / tan(GROUND_CAMERA_FOV / 2 * CV_PI / 180);
+    double tPitch = atan((cy - tHorizon) / tFocal);
+    double tHeight = RAIL_GAUGE * cos(tPitch) / k;
+    if (tHeight < GROUND_HEIGHT_MIN || tHeight > GROUND_HEIGHT_MAX)
+        return false;
+    mFocal = tFocal;
+    mPitch = tPitch;
+    mHeight = tHeight;
+
+    // A ray through (x, y, 1) in normalized camera coordinates hits the
+    // ground at depth t = h / (y*cos + sin)
+    double c = cos(mPitch), s = sin(mPitch);
+    cv::Mat tIntrinsicsInverse = (cv::Mat_<double>(3, 3) << 1/mFocal, 0, -cx/mFocal,
+                                                              0, 1/mFocal, -cy/mFocal,
+                                                              0, 0, 1);
+    cv::Mat tProjection = (cv::Mat_<double>(3, 3) << mHeight, 0, 0,
+                                                      0, -mHeight * s, mHeight * c,
+                                                      0, c, s);
+    mHomography = tProjection * tIntrinsicsInverse;
+
+    // Tabulate the depth and lateral scale of every row
+    mDepth.assign(mSize.height, 0);
+    mLateral.assign(mSize.height, 0);
+    for (int v = 0; v < mSize.height; v++)
+    {
+        double y = (v - cy) / mFocal;
+        double tDenominator = y * c + s;
+        if (tDenominator <= 1e-6)
+            continue;
+        double t = mHeight / tDenominator;
+        mDepth[v] = t * (c - y * s);
+        mLateral[v] = t / mFocal;
+    }
+
+    mCalibrated = true;
+    return true;
+}
@@ -0,0 +1,70 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef GROUNDPLANE_H
+#define GROUNDPLANE_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include <utility>
+#include "framefeatures.h"
+
+// Distance between the rails, in meters (Ghent runs on metre gauge)
+#define RAIL_GAUGE 1.0
+
+/*
+  The GroundPlane maps image points onto the (flat) ground in front of the
+  camera. It calibrates itself from the detected rails: on flat ground the
+  distance between two parallel rails, in pixels, grows linearly with the
+  row, as k*(v - v0). The row where that distance vanishes is the horizon,
+  which gives the pitch of the camera, and since we know the gauge of the
+  rails, k gives its height. Together with the focal length (derived from
+  the field of view) that fixes the homography between the image and the
+  ground.
+
+  Once calibrated, the depth and the lateral scale of every image row are
+  stored in a lookup table, so locating a point on the ground costs nothing.
+  */
+class GroundPlane
+{
+public:
+    // Construction and destruction
+    GroundPlane();
+
+    // Calibration
+    void calibrate();
+    bool calibrating() const;
+    bool calibrated() const;
+    int progress() const;
+    void observe(const std::pair<Track, Track>& iTracks, cv::Size iFrameSize);
+    double height() const;
+    double pitch() const;
+    const cv::Mat& homography() const;
+
+    // Mapping
+    bool toGround(cv::Point iPoint, cv::Point2d& oGround) const;
+    double distance(cv::Point iPoint) const;
+    int row(double iDepth) const;
+
+private:
+    // Auxiliary
+    bool fit();
+
+    // Calibration data
+    bool mCalibrating, mCalibrated;
+    int mFrames;
+    std::vector<double> mRows, mWidths;
+
+    // Camera model
+    cv::Size mSize;
+    double mFocal, mHeight, mPitch;
+    cv::Mat mHomography;
+
+    // Lookup tables, per row
+    std::vector<double> mDepth, mLateral;
+};
+
+#endif // GROUNDPLANE_H
@@ -0,0 +1,372 @@
+//
+// Configuration
+//
+
+// Includes
+#include "logger.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <QMutexLocker>
+#include <QThreadStorage>
+
+// Logging properties
+#define LOG_DEFAULT_LEVEL LOG_INFO
+#define LOG_STATUS_INTERVAL 1000    // between reports of the same status, in milliseconds
+#define LOG_POLL_INTERVAL 50        // between drains of the rings, in milliseconds
+
+// Names, in order of the enumerations
+static const char* gLevelNames[] = { "debug", "info", "warning", "error" };
+static const char* gCategoryNames[] = { "general", "track", "tram", "distance", "collision", "pedestrian", "vehicle", "capture", "server" };
+
+
+//
+// Construction and destruction
+//
+
+Logger::Logger() : mDropped(0), mStopping(false)
+{
+    for (int i = 0; i < LOG_CATEGORIES; i++)
+        mLevels[i] = LOG_DEFAULT_LEVEL;
+    mClock.start();
+    start();
+}
+
+
+//
+// Logging
+//
+
+bool Logger::enabled(LogLevel iLevel, LogCategory iCategory) const
+{
+    return iLevel >= mLevels[iCategory];
+}
+
+void Logger::log(LogLevel iLevel, LogCategory iCategory, const char* iFormat,
+                 const LogArgument& iArgument1, const LogArgument& iArgument2,
+                 const LogArgument& iArgument3, const LogArgument& iArgument4,
+                 const LogArgument& iArgument5, const LogArgument& iArgument6,
+                 const LogArgument& iArgument7, const LogArgument& iArgument8)
+{
+    if (!enabled(iLevel, iCategory))
+        return;
+
+    // Claim a record, or drop the message if the output thread fell behind
+    Ring* tRing = ring();
+    unsigned int tHead = (int) tRing->head;
+    if (tHead - (unsigned int) tRing->tail.fetchAndAddAcquire(0) >= LOG_RING_SIZE)
+    {
+        tRing->dropped.ref();
+        return;
+    }
+    Record& tRecord = tRing->records[tHead & (LOG_RING_SIZE - 1)];
+    tRecord.time = mClock.elapsed();
+    tRecord.level = iLevel;
+    tRecord.category = iCategory;
+    tRecord.format = iFormat;
+
+    // Copy the strings which may not outlive this call
+    const LogArgument* tArguments[LOG_MAX_ARGUMENTS] = { &iArgument1, &iArgument2, &iArgument3, &iArgument4, &iArgument5, &iArgument6, &iArgument7, &iArgument8 };
+    size_t tText = 0;
+    for (int i = 0; i < LOG_MAX_ARGUMENTS; i++)
+    {
+        LogArgument& tArgument = tRecord.arguments[i];
+        tArgument = *tArguments[i];
+        if (tArgument.type == LogArgument::TEXT)
+        {
+            size_t tLength = std::min(tArgument.text.length, LOG_TEXT_SIZE - tText);
+            memcpy(tRecord.text + tText, tArgument.text.data, tLength);
+            tArgument.text.data = 0;
+            tArgument.text.offset = tText;
+            tArgument.text.length = tLength;
+            tText += tLength;
+        }
+    }
+
+    // Publish it
+    tRing->head.fetchAndStoreRelease(tHead + 1);
+}
+
+// Report why a feature wasn't found, unless that same reason has been
+// reported recently by this thread. Not finding something is routine, and
+// only logged when debugging.
+void Logger::status(LogCategory iCategory, const FeatureStatus& iStatus)
+{
+    LogLevel tLevel;
+    switch (iStatus.reason())
+    {
+    case REASON_FOUND:
+        return;
+    case REASON_NOT_FOUND:
+    case REASON_MISSING_INPUT:
+        tLevel = LOG_DEBUG;
+        break;
+    case REASON_REJECTED:
+    case REASON_UNCALIBRATED:
+        tLevel = LOG_INFO;
+        break;
+    default:
+        tLevel = LOG_ERROR;
+        break;
+    }
+    if (!enabled(tLevel, iCategory))
+        return;
+
+    // The limits of a ring are only used by the thread owning it
+    qint64 tNow = mClock.elapsed();
+    std::map<std::pair<LogCategory, const char*>, Limit>& tLimits = ring()->limits;
+    std::map<std::pair<LogCategory, const char*>, Limit>::iterator tLimit = tLimits.find(std::make_pair(iCategory, iStatus.message()));
+    unsigned long tSuppressed = 0;
+    if (tLimit == tLimits.end())
+    {
+        Limit tNew = { tNow, 0 };
+        tLimits.insert(std::make_pair(std::make_pair(iCategory, iStatus.message()), tNew));
+    }
+    else if (tNow - tLimit->second.logged < LOG_STATUS_INTERVAL)
+    {
+        tLimit->second.suppressed++;
+        return;
+    }
+    else
+    {
+        tSuppressed = tLimit->second.suppressed;
+        tLimit->second.logged = tNow;
+        tLimit->second.suppressed = 0;
+    }
+
+    if (iStatus.value() != 0)
+    {
+        if (tSuppressed > 0)
+            log(tLevel, iCategory, "{} ({}) [{} more since]", iStatus.message(), iStatus.value(), tSuppressed);
+        else
+            log(tLevel, iCategory, "{} ({})", iStatus.message(), iStatus.value());
+    }
+    else
+    {
+        if (tSuppressed > 0)
+            log(tLevel, iCategory, "{} [{} more since]", iStatus.message(), tSuppressed);
+        else
+            log(tLevel, iCategory, "{}", iStatus.message());
+    }
+}
+
+
+//
+// Configuration
+//
+
+void Logger::setLevel(LogLevel iLevel)
+{
+    for (int i = 0; i < LOG_CATEGORIES; i++)
+        mLevels[i] = iLevel;
+}
+
+void Logger::setLevel(LogCategory iCategory, LogLevel iLevel)
+{
+    mLevels[iCategory] = iLevel;
+}
+
+bool Logger::parseLevel(const std::string& iName, LogLevel& oLevel)
+{
+    for (int i = LOG_DEBUG; i <= LOG_ERROR; i++)
+    {
+        if (iName == gLevelNames[i])
+        {
+            oLevel = (LogLevel) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Logger::name(LogCategory iCategory)
+{
+    return gCategoryNames[iCategory];
+}
+
+
+//
+// Output
+//
+
+// Write out whatever has been logged so far, and stop the output thread
+void Logger::stop()
+{
+    mStopping = true;
+    wait();
+}
+
+// Messages which didn't fit in the ring of their thread
+unsigned long Logger::dropped()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mDropped;
+}
+
+
+//
+// Logger of the process
+//
+
+// The logger never gets destroyed, as threads may still be logging while
+// the process exits
+Logger& Logger::instance()
+{
+    static Logger* tLogger = new Logger();
+    return *tLogger;
+}
+
+
+//
+// Output thread
+//
+
+void Logger::run()
+{
+    std::string tOutput;
+    bool tStopping = false;
+    while (!tStopping)
+    {
+        tStopping = mStopping;
+
+        // Drain every ring, and let go of the ones of threads which ended
+        QMutexLocker tLocker(&mMutex);
+        for (size_t i = 0; i < mRings.size(); )
+        {
+            if (drain(mRings[i], tOutput))
+            {
+                delete mRings[i];
+                mRings.erase(mRings.begin() + i);
+            }
+            else
+                i++;
+        }
+        tLocker.unlock();
+
+        if (!tOutput.empty())
+        {
+            std::cout << tOutput;
+            std::cout.flush();
+            tOutput.clear();
+        }
+        if (!tStopping)
+            msleep(LOG_POLL_INTERVAL);
+    }
+}
+
+
+//
+// Auxiliary
+//
+
+// Lets go of the ring of a thread once it ends (the ring itself lives on
+// until the output thread emptied it)
+struct Logger::RingOwner
+{
+    RingOwner(Ring* iRing) : ring(iRing) {}
+    ~RingOwner() { ring->abandoned.fetchAndStoreRelease(1); }
+    Ring* ring;
+};
+
+// Ring of the calling thread, registered on its first message
+Logger::Ring* Logger::ring()
+{
+    static QThreadStorage<RingOwner*> gRingOwners;
+    if (!gRingOwners.hasLocalData())
+    {
+        Ring* tRing = new Ring();
+        {
+            QMutexLocker tLocker(&mMutex);
+            mRings.push_back(tRing);
+        }
+        gRingOwners.setLocalData(new RingOwner(tRing));
+    }
+    return gRingOwners.localData()->ring;
+}
+
+// Format the messages of a ring. Returns whether the ring can be deleted,
+// as its thread ended and all its messages have been written.
+bool Logger::drain(Ring* iRing, std::string& oOutput)
+{
+    bool tAbandoned = iRing->abandoned.fetchAndAddAcquire(0) != 0;
+    unsigned int tHead = iRing->head.fetchAndAddAcquire(0);
+    unsigned int tTail = (int) iRing->tail;
+    for (; tTail != tHead; tTail++)
+        format(iRing->records[tTail & (LOG_RING_SIZE - 1)], oOutput);
+    iRing->tail.fetchAndStoreRelease(tTail);
+
+    int tDropped = iRing->dropped.fetchAndStoreRelaxed(0);
+    if (tDropped > 0)
+    {
+        mDropped += tDropped;
+        std::ostringstream tLine;
+        tLine << "  (" << tDropped << " messages dropped)\n";
+        oOutput += tLine.str();
+    }
+    return tAbandoned;
+}
+
+// Format a message as a line of output
+void Logger::format(const Record& iRecord, std::string& oOutput)
+{
+    std::ostringstream tLine;
+    tLine << std::fixed << std::setprecision(3) << std::setw(10) << iRecord.time / 1000.0
+          << " " << std::left << std::setw(8) << gLevelNames[iRecord.level] << std::right
+          << gCategoryNames[iRecord.category] << ": ";
+    tLine.unsetf(std::ios_base::floatfield);
+    tLine << std::setprecision(6);
+
+    int tArgument = 0;
+    for (const char* c = iRecord.format; *c != 0; c++)
+    {
+        // Placeholders are "{}", or "{.N}" for N decimals
+        int tPrecision = -1;
+        if (c[0] == '{' && c[1] == '}')
+            c += 1;
+        else if (c[0] == '{' && c[1] == '.' && c[2] >= '0' && c[2] <= '9' && c[3] == '}')
+        {
+            tPrecision = c[2] - '0';
+            c += 3;
+        }
+        else
+        {
+            tLine << *c;
+            continue;
+        }
+        if (tArgument >= LOG_MAX_ARGUMENTS)
+            continue;
+
+        const LogArgument& tValue = iRecord.arguments[tArgument++];
+        switch (tValue.type)
+        {
+        case LogArgument::NONE:
+            break;
+        case LogArgument::INTEGER:
+            tLine << tValue.integer;
+            break;
+        case LogArgument::UNSIGNED:
+            tLine << tValue.natural;
+            break;
+        case LogArgument::REAL:
+            if (tPrecision >= 0)
+            {
+                tLine << std::fixed << std::setprecision(tPrecision) << tValue.real;
+                tLine.unsetf(std::ios_base::floatfield);
+                tLine << std::setprecision(6);
+            }
+            else
+                tLine << tValue.real;
+            break;
+        case LogArgument::LITERAL:
+            tLine << (tValue.literal != 0 ? tValue.literal : "");
+            break;
+        case LogArgument::TEXT:
+            tLine.write(iRecord.text + tValue.text.offset, tValue.text.length);
+            break;
+        }
+    }
+    tLine << '\n';
+    oOutput += tLine.str();
+}
@@ -0,0 +1,178 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef LOGGER_H
+#define LOGGER_H
+
+// Includes
+#include <string>
+#include <map>
+#include <vector>
+#include <utility>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "featurestatus.h"
+
+// Logging properties
+#define LOG_MAX_ARGUMENTS 8
+#define LOG_TEXT_SIZE 96            // room for copied strings per record, in bytes
+#define LOG_RING_SIZE 256           // records per thread, a power of two
+
+// Enumerations
+enum LogLevel {
+    LOG_DEBUG = 0,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR
+};
+
+enum LogCategory {
+    LOG_GENERAL = 0,
+    LOG_TRACK,
+    LOG_TRAM,
+    LOG_DISTANCE,
+    LOG_COLLISION,
+    LOG_PEDESTRIAN,
+    LOG_VEHICLE,
+    LOG_CAPTURE,
+    LOG_SERVER,
+    LOG_CATEGORIES
+};
+
+/*
+  An argument of a log message, stored in binary form: it only gets
+  formatted by the output thread. String literals are kept as a pointer,
+  any other string gets copied into the record (up to LOG_TEXT_SIZE bytes
+  per record), so don't pass the c_str() of a temporary as a literal.
+  */
+struct LogArgument
+{
+    enum Type { NONE, INTEGER, UNSIGNED, REAL, LITERAL, TEXT };
+
+    LogArgument() : type(NONE) {}
+    LogArgument(int iValue) : type(INTEGER) { integer = iValue; }
+    LogArgument(long iValue) : type(INTEGER) { integer = iValue; }
+    LogArgument(long long iValue) : type(INTEGER) { integer = iValue; }
+    LogArgument(unsigned int iValue) : type(UNSIGNED) { natural = iValue; }
+    LogArgument(unsigned long iValue) : type(UNSIGNED) { natural = iValue; }
+    LogArgument(unsigned long long iValue) : type(UNSIGNED) { natural = iValue; }
+    LogArgument(double iValue) : type(REAL) { real = iValue; }
+    LogArgument(const char* iValue) : type(LITERAL) { literal = iValue; }
+    LogArgument(const std::string& iValue) : type(TEXT) { text.data = iValue.data(); text.offset = 0; text.length = iValue.size(); }
+
+    struct Text
+    {
+        const char* data;       // only valid while logging
+        size_t offset;          // in the text of the record
+        size_t length;
+    };
+
+    Type type;
+    union
+    {
+        long long integer;
+        unsigned long long natural;
+        double real;
+        const char* literal;
+        Text text;
+    };
+};
+
+/*
+  The Logger collects diagnostics from all threads and writes them to the
+  console from a thread of its own. Every thread logs into a ring buffer of
+  its own, without taking a lock or formatting anything: a message is a
+  format string literal plus binary arguments, filled in with "{}" (or
+  "{.N}" for a number with N decimals) only when written out. When a ring is
+  full the message gets dropped (and counted) rather than stalling the
+  thread. The output thread drains all rings periodically, and flushes the
+  console once per batch.
+
+  Messages below the level of their category are discarded right away. The
+  reasons why features weren't found repeat on nearly every frame of a
+  scene without them, so those are rate limited as well: every reason gets
+  logged at most once per interval per thread, with the amount of reports
+  suppressed in the meantime.
+  */
+class Logger : public QThread
+{
+public:
+    // Logging
+    bool enabled(LogLevel iLevel, LogCategory iCategory) const;
+    void log(LogLevel iLevel, LogCategory iCategory, const char* iFormat,
+             const LogArgument& iArgument1 = LogArgument(), const LogArgument& iArgument2 = LogArgument(),
+             const LogArgument& iArgument3 = LogArgument(), const LogArgument& iArgument4 = LogArgument(),
+             const LogArgument& iArgument5 = LogArgument(), const LogArgument& iArgument6 = LogArgument(),
+             const LogArgument& iArgument7 = LogArgument(), const LogArgument& iArgument8 = LogArgument());
+    void status(LogCategory iCategory, const FeatureStatus& iStatus);
+
+    // Configuration
+    void setLevel(LogLevel iLevel);
+    void setLevel(LogCategory iCategory, LogLevel iLevel);
+    static bool parseLevel(const std::string& iName, LogLevel& oLevel);
+    static const char* name(LogCategory iCategory);
+
+    // Output
+    void stop();
+    unsigned long dropped();
+
+    // Logger of the process
+    static Logger& instance();
+
+protected:
+    // Output thread
+    void run();
+
+private:
+    // A logged message
+    struct Record
+    {
+        qint64 time;
+        LogLevel level;
+        LogCategory category;
+        const char* format;
+        LogArgument arguments[LOG_MAX_ARGUMENTS];
+        char text[LOG_TEXT_SIZE];
+    };
+
+    // How often a status got reported
+    struct Limit
+    {
+        qint64 logged;
+        unsigned long suppressed;
+    };
+
+    // Messages of a single thread, written by that thread only, and read by
+    // the output thread only
+    struct Ring
+    {
+        Ring() : head(0), tail(0), dropped(0), abandoned(0) {}
+
+        Record records[LOG_RING_SIZE];
+        QAtomicInt head, tail, dropped, abandoned;
+        std::map<std::pair<LogCategory, const char*>, Limit> limits;
+    };
+
+    // Construction and destruction
+    Logger();
+
+    // Auxiliary
+    struct RingOwner;
+    Ring* ring();
+    bool drain(Ring* iRing, std::string& oOutput);
+    static void format(const Record& iRecord, std::string& oOutput);
+
+    // Member data
+    QElapsedTimer mClock;
+    volatile int mLevels[LOG_CATEGORIES];
+    QMutex mMutex;
+    std::vector<Ring*> mRings;
+    unsigned long mDropped;
+    volatile bool mStopping;
+};
+
+#endif // LOGGER_H
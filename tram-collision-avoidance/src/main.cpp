@@ -5,21 +5,122 @@
 // Headers
 #include <exception>
 #include <QtCore/QTextStream>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
 #include <QtGui/QApplication>
 #include "mainwindow.h"
+#include "streamserver.h"
+#include "logger.h"
+#include "metrics.h"
+#include "alertoutput.h"
+
+// Definitions
+#define METRICS_DUMP_INTERVAL 10000     // between writes of the metrics file, in milliseconds
 
 //
 // Main
 //
 
+// Publish alerts with "--alert-socket PATH", which any mode accepts
+void configure_alerts(int argc, char** argv)
+{
+    for (int i = 1; i+1 < argc; i++)
+    {
+        if (QString(argv[i]) == "--alert-socket")
+            AlertOutput::instance().open(argv[i+1]);
+    }
+}
+
+// Export the metrics with "--metrics-port PORT" (over HTTP on localhost)
+// and/or "--metrics-file PATH", which any mode accepts
+void configure_metrics(int argc, char** argv, MetricsExporter& iExporter)
+{
+    bool tExport = false;
+    for (int i = 1; i+1 < argc; i++)
+    {
+        if (QString(argv[i]) == "--metrics-port")
+        {
+            iExporter.setPort(QString(argv[i+1]).toUShort());
+            tExport = true;
+        }
+        else if (QString(argv[i]) == "--metrics-file")
+        {
+            iExporter.setFile(argv[i+1], METRICS_DUMP_INTERVAL);
+            tExport = true;
+        }
+    }
+    if (tExport)
+        iExporter.start();
+}
+
+// Apply a "--log-level LEVEL" argument, which any mode accepts
+void configure_logging(int argc, char** argv)
+{
+    for (int i = 1; i+1 < argc; i++)
+    {
+        if (QString(argv[i]) != "--log-level")
+            continue;
+        LogLevel tLevel;
+        if (Logger::parseLevel(argv[i+1], tLevel))
+            Logger::instance().setLevel(tLevel);
+        else
+            Logger::instance().log(LOG_WARNING, LOG_GENERAL, "unknown log level {}, use debug, info, warning or error", std::string(argv[i+1]));
+    }
+}
+
+// Process streams without an interface:
+//   --serve [--threads N] [--priority P] [--log-level LEVEL]
+//           [--metrics-port PORT] [--metrics-file PATH] [--alert-socket PATH] SOURCE...
+// where a priority applies to all sources after it
+int serve(int argc, char** argv)
+{
+    QCoreApplication tApplication(argc, argv);
+    QStringList tArguments = tApplication.arguments();
+
+    int tThreads = QThread::idealThreadCount(), tPriority = 0;
+    QStringList tSources;
+    QList<int> tPriorities;
+    for (int i = 2; i < tArguments.size(); i++)
+    {
+        if (tArguments[i] == "--threads" && i+1 < tArguments.size())
+            tThreads = tArguments[++i].toInt();
+        else if (tArguments[i] == "--priority" && i+1 < tArguments.size())
+            tPriority = tArguments[++i].toInt();
+        else if ((tArguments[i] == "--log-level" || tArguments[i] == "--metrics-port" ||
+                  tArguments[i] == "--metrics-file" || tArguments[i] == "--alert-socket") && i+1 < tArguments.size())
+            i++;
+        else
+        {
+            tSources << tArguments[i];
+            tPriorities << tPriority;
+        }
+    }
+
+    StreamServer tServer(tThreads);
+    for (int i = 0; i < tSources.size(); i++)
+        tServer.add(tSources[i], tPriorities[i]);
+    return tServer.exec();
+}
+
 int main(int argc, char** argv)
 {
+    int tResult = 1;
+    MetricsExporter tExporter(Metrics::instance());
     try
     {
-        QApplication tApplication(argc, argv);
-        MainWindow tWindow;
-        tWindow.show();
-        return tApplication.exec();
+        configure_logging(argc, argv);
+        configure_metrics(argc, argv, tExporter);
+        configure_alerts(argc, argv);
+        if (argc > 1 && QString(argv[1]) == "--serve")
+            tResult = serve(argc, argv);
+        else
+        {
+            QApplication tApplication(argc, argv);
+            MainWindow tWindow;
+            tWindow.show();
+            tResult = tApplication.exec();
+        }
     }
     catch (std::exception iException)
     {
@@ -31,5 +132,11 @@ int main(int argc, char** argv)
         qerr << "\n";
         qerr << iException.what();
     }
+
+    // Write out whatever is still queued
+    AlertOutput::instance().close();
+    tExporter.stop();
+    Logger::instance().stop();
+    return tResult;
 }
 
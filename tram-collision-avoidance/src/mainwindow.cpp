@@ -8,34 +8,29 @@
 #include <QtGui/QVBoxLayout>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <string>
-#include "trackdetection.h"
-#include "tramdetection.h"
-#include "tramdistance.h"
-#include "pedestriandetection.h"
-#include "vehicledetection.h"
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QDebug>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 // Definitions
-#define FEATURES_MAX_AGE 10
+#define FEATURES_HEADING_FRAMES 10      // how far ahead to draw a moving object
+#define LIVE_POLL_INTERVAL 5            // in milliseconds, while waiting for a new frame
 
 
 //
 // Construction and destruction
 //
 
-MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), mUI(new Ui::MainWindow)
+MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), mUI(new Ui::MainWindow), mPipeline(&mResources)
 {
     // Initialize application
     mSettings = new QSettings("Beeldverwerking", "Tram Collision Detection");
     mVideoCapture = 0;
-#if WRITE_VIDEO
-    mVideoWriter = 0;
-#endif
 
     // Setup interface
     mUI->setupUi(this);
@@ -72,6 +67,11 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), mUI(new Ui::MainW
 #else
     mUI->statusBar->showMessage("Application initialized (singelthreaded execution)");
 #endif
+    mFramePosition = 0;
+    mFramesSkipped = 0;
+    mLatency = 0;
+    mLatencyTotal = 0;
+    restartPlayback();
     mFrameCounter = 0; drawStats();
     setTitle();
 }
@@ -84,15 +84,9 @@ MainWindow::~MainWindow()
             mVideoCapture->release();
         delete mVideoCapture;
     }
+    mFrameGrabber.close();
 
-#if WRITE_VIDEO
-    if (mVideoWriter != 0)
-    {
-        if (mVideoWriter->isOpened())
-            mVideoWriter->release();
-        delete mVideoWriter;
-    }
-#endif
+    mVideoRecorder.close();
 
     delete mUI;
 }
@@ -112,6 +106,7 @@ void MainWindow::on_btnStart_clicked()
     mUI->btnStop->setEnabled(true);
     mUI->btnStop->setFocus();
     mProcessing = true;
+    restartPlayback();
     process();
 }
 
@@ -125,6 +120,12 @@ void MainWindow::on_btnStop_clicked()
     mUI->btnStop->setEnabled(false);
 }
 
+void MainWindow::on_chkRealtime_toggled(bool iChecked)
+{
+    mPipeline.scheduler().setRealtime(iChecked);
+    restartPlayback();
+}
+
 void MainWindow::on_actOpen_triggered()
 {
     QString tFilename = QFileDialog::getOpenFileName(this, tr("Open Video"), "", tr("Video Files (*.avi *.mp4)"));
@@ -132,6 +133,15 @@ void MainWindow::on_actOpen_triggered()
     mUI->btnStart->setEnabled(true);
 }
 
+void MainWindow::on_actOpenStream_triggered()
+{
+    bool tAccepted;
+    QString tSource = QInputDialog::getText(this, tr("Open Camera or Stream"), tr("Device (/dev/video0, or 0) or stream URL:"),
+                                            QLineEdit::Normal, mSettings->value("lastStream", "0").toString(), &tAccepted);
+    if (tAccepted && !tSource.isEmpty())
+        openStream(tSource);
+}
+
 void MainWindow::on_actRecentFile_triggered()
 {
     QAction *tAction = qobject_cast<QAction *>(sender());
@@ -139,28 +149,70 @@ void MainWindow::on_actRecentFile_triggered()
         openFile(tAction->data().toString());
 }
 
+void MainWindow::on_actRecord_toggled(bool iChecked)
+{
+    if (!iChecked)
+    {
+        if (mVideoRecorder.isRecording())
+        {
+            mVideoRecorder.close();
+            statusBar()->showMessage("Stopped recording (" + QString::number(mVideoRecorder.written()) + " frames written, " + QString::number(mVideoRecorder.dropped()) + " dropped)");
+        }
+        return;
+    }
+
+    // We need an input video to know the output geometry
+    double tFps;
+    cv::Size tSize;
+    if (mFrameGrabber.isOpen())
+    {
+        tFps = mFrameGrabber.fps();
+        tSize = mFrameGrabber.size();
+    }
+    else if (mVideoCapture != 0 && mVideoCapture->isOpened())
+    {
+        tFps = mVideoCapture->get(CV_CAP_PROP_FPS);
+        tSize = cv::Size(mVideoCapture->get(CV_CAP_PROP_FRAME_WIDTH), mVideoCapture->get(CV_CAP_PROP_FRAME_HEIGHT));
+    }
+    else
+    {
+        statusBar()->showMessage("Error: open a video before recording");
+        mUI->actRecord->setChecked(false);
+        return;
+    }
+
+    QString tFilename = QFileDialog::getSaveFileName(this, tr("Record Video"), "", tr("Video Files (*.avi)"));
+    if (tFilename.isEmpty())
+    {
+        mUI->actRecord->setChecked(false);
+        return;
+    }
+
+    VideoRecorder::Policy tPolicy = mUI->actRecordBlocking->isChecked() ? VideoRecorder::BLOCK : VideoRecorder::DROP;
+    if (!mVideoRecorder.open(tFilename.toStdString(), tFps, tSize, tPolicy))
+    {
+        statusBar()->showMessage("Error: could not open output file");
+        mUI->actRecord->setChecked(false);
+        return;
+    }
+    statusBar()->showMessage("Recording to " + strippedName(tFilename));
+}
+
 
 //
 // File and video processing
 //
 
-bool MainWindow::openFile(QString iFilename)
+void MainWindow::on_actCalibrate_triggered()
 {
-    // Do we need to clean up a previous file?
-    mProcessing = false;
-    if (mVideoCapture != 0)
-    {
-        // Close and delete the capturer
-        if (mVideoCapture->isOpened())
-            mVideoCapture->release();
-        delete mVideoCapture;
-        mVideoCapture = 0;
+    mPipeline.groundPlane().calibrate();
+    statusBar()->showMessage("Calibrating the ground plane on the next frames with tracks");
+}
 
-        // Update the interface
-        mUI->btnStart->setEnabled(false);
-        mFrameCounter = 0; drawStats();
-        setTitle();
-    }
+bool MainWindow::openFile(QString iFilename)
+{
+    // Do we need to clean up a previous input?
+    closeInput();
 
     // Check if we can open the file
     if (! QFileInfo(iFilename).isReadable())
@@ -177,220 +229,243 @@ bool MainWindow::openFile(QString iFilename)
         return false;
     }
     //mGLWidget->setMinimumSize(mVideoCapture->get(CV_CAP_PROP_FRAME_WIDTH), mVideoCapture->get(CV_CAP_PROP_FRAME_HEIGHT));
+    resetInput(mVideoCapture->get(CV_CAP_PROP_FPS));
 
-    // Open output video
-#if WRITE_VIDEO
-    std::string oVideoFile = argv[2];
-    mVideoWriter = new cv::VideoWriter(oVideoFile,
-                                       CV_FOURCC('M', 'J', 'P', 'G'),
-                                       mVideoCapture->get(CV_CAP_PROP_FPS),
-                                       cv::Size(mVideoCapture->get(CV_CAP_PROP_FRAME_WIDTH), mVideoCapture->get(CV_CAP_PROP_FRAME_HEIGHT)),
-                                       true);
-#endif
+    statusBar()->showMessage("File opened and loaded");
+    mUI->btnStart->setEnabled(true);
+    mUI->btnStop->setEnabled(false);
+    setCurrentFile(iFilename);
+    return true;
+}
 
-    // Reset time counters
-    mFrameCounter = 0;
-    mTimePreprocess = 0;
-    mTimeTrack = 0;
-    mTimeTram = 0;
-    mTimeDistance = 0;
-    mTimePedestrians = 0;
-    mTimeVehicle = 0;
-    mTimeDraw = 0;
+// Open a live source, which gets captured on a thread of its own
+bool MainWindow::openStream(QString iSource)
+{
+    // Do we need to clean up a previous input?
+    closeInput();
 
-    // Reset age trackers
-    mAgeTrack = 0;
-    mAgeTram = 0;
-    mAgePedestrian = 0;
-    mAgeVehicle = 0;
+    if (!mFrameGrabber.open(iSource.toStdString()))
+    {
+        statusBar()->showMessage("Error: could not open " + iSource);
+        return false;
+    }
+    resetInput(mFrameGrabber.fps());
 
-    statusBar()->showMessage("File opened and loaded");
+    statusBar()->showMessage("Capturing from " + iSource);
     mUI->btnStart->setEnabled(true);
     mUI->btnStop->setEnabled(false);
-    setCurrentFile(iFilename);
+    mSettings->setValue("lastStream", iSource);
+    setTitle(iSource);
     return true;
 }
 
+void MainWindow::closeInput()
+{
+    mProcessing = false;
+    mUI->actRecord->setChecked(false);
+    if (mVideoCapture == 0 && !mFrameGrabber.isOpen())
+        return;
+
+    // Close and delete the capturer
+    if (mVideoCapture != 0)
+    {
+        if (mVideoCapture->isOpened())
+            mVideoCapture->release();
+        delete mVideoCapture;
+        mVideoCapture = 0;
+    }
+    mFrameGrabber.close();
+
+    // Update the interface
+    mUI->btnStart->setEnabled(false);
+    mFrameCounter = 0; drawStats();
+    setTitle();
+}
+
+// Start over with a fresh input
+void MainWindow::resetInput(double iFps)
+{
+    // Reset time counters
+    mFrameCounter = 0;
+    mTimeDraw = 0;
+    mLatency = 0;
+    mLatencyTotal = 0;
+
+    // Reset the features and real-time playback
+    mPipeline.reset(iFps);
+    mFramePosition = 0;
+    mFramesSkipped = 0;
+    restartPlayback();
+}
+
 void MainWindow::process()
 {
-    if (mProcessing && mVideoCapture->isOpened())
+    if (mProcessing && mFrameGrabber.isOpen())
+        processLive();
+    else if (mProcessing && mVideoCapture != 0 && mVideoCapture->isOpened())
     {
         mTimer.restart();
+
+        // In real-time mode, skip the frames we're already too late for, so
+        // we always process the frame which should be shown right now
+        if (mPipeline.scheduler().realtime())
+        {
+            unsigned long tTarget = mPlaybackOrigin + mPlaybackClock.elapsed() / mPipeline.scheduler().deadline();
+            while (mFramePosition < tTarget && mVideoCapture->grab())
+            {
+                mFramePosition++;
+                mFramesSkipped++;
+            }
+        }
+
         cv::Mat tFrame;
         *mVideoCapture >> tFrame;
         if (tFrame.data)
         {
-            processFrame(tFrame);
+            processFrame(tFrame, mFramePosition++, mVideoCapture->get(CV_CAP_PROP_POS_MSEC));
             mFrameCounter++;
             drawStats();
-            QTimer::singleShot(25, this, SLOT(process()));
+            QTimer::singleShot(mPipeline.scheduler().realtime() ? 0 : 25, this, SLOT(process()));
         }
     }
 }
 
-void MainWindow::processFrame(cv::Mat &iFrame)
+// Process the newest captured frame. A live source doesn't wait for us, so
+// whatever got captured in the meantime has been dropped by the grabber.
+void MainWindow::processLive()
 {
-    // Load objects
-    TrackDetection tTrackDetection(&iFrame);
-    TramDetection tTramDetection(&iFrame);
-    TramDistance tTramDistance(&iFrame);
-    PedestrianDetection tPedestrianDetection(&iFrame);
-    VehicleDetection tVehicleDetection(&iFrame);
-
-    // Preprocess
-    timeStart();
-#pragma omp parallel sections
+    mTimer.restart();
+
+    cv::Mat tFrame;
+    FrameGrabber::Stamp tStamp;
+    if (!mFrameGrabber.latest(tFrame, tStamp))
     {
-#pragma omp section
-        {
-            tTrackDetection.preprocess();
-        }
-#pragma omp section
+        if (mFrameGrabber.finished())
         {
-            tTramDetection.preprocess();
-        }
-#pragma omp section
-        {
-            tTramDistance.preprocess();
-        }
-#pragma omp section
-        {
-            tPedestrianDetection.preprocess();
-        }
-#pragma omp section
-        {
-            tVehicleDetection.preprocess();
+            on_btnStop_clicked();
+            statusBar()->showMessage("Stream ended");
         }
+        else
+            QTimer::singleShot(LIVE_POLL_INTERVAL, this, SLOT(process()));
+        return;
     }
-    mTimePreprocess += timeDelta();
 
+    // Number frames as captured, so features age with the dropped ones too
+    processFrame(tFrame, tStamp.sequence, tStamp.position);
+    mFrameCounter++;
+    mLatency = mFrameGrabber.elapsed() - tStamp.captured;
+    mLatencyTotal += mLatency;
+    mPipeline.reportCapture(mLatency, mFrameGrabber.dropped());
+    drawStats();
+    QTimer::singleShot(0, this, SLOT(process()));
+}
+
+void MainWindow::processFrame(cv::Mat &iFrame, unsigned long iFrameNumber, double iTimestamp)
+{
     // Find features
+    cv::Mat tVisualisation;
+    mPipeline.process(iFrame, iFrameNumber, iTimestamp, (DebugView) mUI->slcType->currentIndex(), tVisualisation);
+
+    // Draw image
     timeStart();
-    try
-    {
-        tTrackDetection.find_features(mFeatures);
-        mAgeTrack = mFrameCounter;
-    }
-    catch (FeatureException e)
-    {
-        std::cout << "  Error finding tracks: " << e.what() << std::endl;
-    }
-    mTimeTrack += timeDelta();
-    try
-    {
-        tTramDetection.find_features(mFeatures);
-        mAgeTram = mFrameCounter;
-    }
-    catch (FeatureException e)
-    {
-        std::cout << "  Error finding tram: " << e.what() << std::endl;
-    }
-    mTimeTram += timeDelta();
-   try
-    {
-        tTramDistance.find_features(mFeatures);
-        mAgeTram = mFrameCounter;
-    }
-    catch (FeatureException e)
-    {
-        std::cout << "  Error finding distance: " << e.what() << std::endl;
-    }
-    mTimeDistance += timeDelta();
+    FeaturePublisher::Snapshot tSnapshot(mPipeline.publisher());
+    const FrameFeatures& tFeatures = *tSnapshot;
 
-    try
-    {
-        tPedestrianDetection.find_features(mFeatures);
-        mAgePedestrian = mFrameCounter;
-    }
-    catch (FeatureException e)
+    // Show the input frame if there's no debug frame
+    if (!tVisualisation.data)
     {
-        std::cout << "  Error finding pedestrians: " << e.what() << std::endl;
+        if (mUI->chkFeatures->isChecked())
+            tVisualisation = iFrame.clone();
+        else
+            tVisualisation = iFrame;
     }
-    mTimePedestrians += timeDelta();
 
-    try
-    {
-        tVehicleDetection.find_features(mFeatures);
-        mAgeVehicle = mFrameCounter;
-    }
-    catch (FeatureException e)
+    // Debug frames are at the working resolution of their component,
+    // while features are expressed in coordinates of the input frame
+    if (tVisualisation.rows != iFrame.rows && mUI->chkFeatures->isChecked())
     {
-        std::cout << "  Error finding vehicles: " << e.what() << std::endl;
+        double tScale = (double) iFrame.rows / tVisualisation.rows;
+        cv::resize(tVisualisation, tVisualisation, cv::Size(), tScale, tScale);
     }
-    mTimeVehicle += timeDelta();
-
-    // Draw image
-    timeStart();
-    cv::Mat tVisualisation;
-    if (mUI->slcType->currentIndex() == 0)
-        tVisualisation = iFrame.clone();
-    else if (mUI->slcType->currentIndex() == 1)
-        tVisualisation = tTrackDetection.frameDebug();
-    else if (mUI->slcType->currentIndex() == 2)
-        tVisualisation = tTramDetection.frameDebug();
-    else if (mUI->slcType->currentIndex() == 3)
-        tVisualisation = tTramDistance.frameDebug();
-    else if (mUI->slcType->currentIndex() == 4)
-        tVisualisation = tPedestrianDetection.frameDebug();
-    else if (mUI->slcType->currentIndex() == 5)
-        tVisualisation = tVehicleDetection.frameDebug();
 
     if (mUI->chkFeatures->isChecked())
     {
         // Draw tracks
-        if (mFeatures.tracks.first.size())
+        if (tFeatures.tracks.first.size())
         {
-            for (int i = 0; i < mFeatures.tracks.first.size()-1; i++)
-                cv::line(tVisualisation, mFeatures.tracks.first[i], mFeatures.tracks.first[i+1], cv::Scalar(0, 255, 0), 3);
+            for (size_t i = 0; i < tFeatures.tracks.first.size()-1; i++)
+                cv::line(tVisualisation, tFeatures.tracks.first[i], tFeatures.tracks.first[i+1], cv::Scalar(0, 255, 0), 3);
         }
-        if (mFeatures.tracks.second.size())
+        if (tFeatures.tracks.second.size())
         {
-            for (int i = 0; i < mFeatures.tracks.second.size()-1; i++)
-                cv::line(tVisualisation, mFeatures.tracks.second[i], mFeatures.tracks.second[i+1], cv::Scalar(0, 255, 0), 3);
+            for (size_t i = 0; i < tFeatures.tracks.second.size()-1; i++)
+                cv::line(tVisualisation, tFeatures.tracks.second[i], tFeatures.tracks.second[i+1], cv::Scalar(0, 255, 0), 3);
         }
 
         // Draw tram
-        cv::rectangle(tVisualisation, mFeatures.tram, cv::Scalar(0, 255, 0), 1);
+        cv::rectangle(tVisualisation, tFeatures.tram, cv::Scalar(0, 255, 0), 1);
 
         // Draw line between middle of the tram and middle of the track
-        cv::line(tVisualisation, mFeatures.trackHalfX, mFeatures.tramHalfX, cv::Scalar(255, 0, 0), 2);
+        cv::line(tVisualisation, tFeatures.trackHalfX, tFeatures.tramHalfX, cv::Scalar(255, 0, 0), 2);
 
         cv::Point textStart;
-        textStart.y = (mFeatures.trackHalfX.y + mFeatures.tramHalfX.y)/2;
-        textStart.x = (mFeatures.trackHalfX.x + mFeatures.tramHalfX.x)/2 + 5;
+        textStart.y = (tFeatures.trackHalfX.y + tFeatures.tramHalfX.y)/2;
+        textStart.x = (tFeatures.trackHalfX.x + tFeatures.tramHalfX.x)/2 + 5;
 
         std::ostringstream o;
-        if (!(o << mFeatures.tramDistance))
+        if (!(o << tFeatures.tramDistance << " m"))
           throw FeatureException("Can not convert distance to string");
-        cv::putText(tVisualisation, o.str()+" m", textStart, cv::FONT_HERSHEY_PLAIN, 1, cv::Scalar(255,0,0));
+        if (tFeatures.timeToCollision > 0)
+            o << std::fixed << std::setprecision(1) << ", " << tFeatures.timeToCollision << " s";
+        cv::putText(tVisualisation, o.str(), textStart, cv::FONT_HERSHEY_PLAIN, 1, cv::Scalar(255,0,0));
 
-        //Draw pedestrians
-        for (size_t i = 0; i < mFeatures.pedestrians.size(); i++) {
-            cv::Rect r = mFeatures.pedestrians[i];
-            cv::rectangle(tVisualisation, r.tl(), r.br(), cv::Scalar(0,0,255), 2);
+        // Draw the path of the tram, and what's in it
+        for (size_t i = 0; i + 1 < tFeatures.corridor.first.size(); i++)
+        {
+            cv::line(tVisualisation, tFeatures.corridor.first[i], tFeatures.corridor.first[i+1], cv::Scalar(0, 255, 255), 1);
+            cv::line(tVisualisation, tFeatures.corridor.second[i], tFeatures.corridor.second[i+1], cv::Scalar(0, 255, 255), 1);
+        }
+        for (size_t i = 0; i < tFeatures.hazards.size(); i++)
+        {
+            if (tFeatures.hazards[i].inside)
+                cv::rectangle(tVisualisation, tFeatures.hazards[i].rect, cv::Scalar(0, 0, 255), 4);
         }
 
+        //Draw pedestrians
+        for (size_t i = 0; i < tFeatures.pedestrianObjects.size(); i++)
+            drawObject(tVisualisation, tFeatures.pedestrianObjects[i], cv::Scalar(0,0,255), 2);
+
         //Draw vehicles
-        for (size_t i = 0; i < mFeatures.vehicles.size(); i++) {
-            cv::Rect r = mFeatures.vehicles[i];
-            cv::rectangle(tVisualisation, r.tl(), r.br(), cv::Scalar(255,0,0), 1);
-        }
+        for (size_t i = 0; i < tFeatures.vehicleObjects.size(); i++)
+            drawObject(tVisualisation, tFeatures.vehicleObjects[i], cv::Scalar(255,0,0), 1);
     }    
     mGLWidget->sendImage(&tVisualisation);
-    mTimeDraw += timeDelta();
 
-    // Check for outdated features
-    if (mFrameCounter - mAgeTrack > FEATURES_MAX_AGE)
+    // Hand the annotated frame to the recorder, which needs its own copy
+    // if we didn't draw on one
+    if (mVideoRecorder.isRecording())
     {
-        mFeatures.tracks.first.clear();
-        mFeatures.tracks.second.clear();
+        if (tVisualisation.data == iFrame.data)
+            tVisualisation = iFrame.clone();
+        mVideoRecorder.push(tVisualisation);
     }
-    if (mFrameCounter - mAgeTram > FEATURES_MAX_AGE)
-        mFeatures.tram = cv::Rect();
-    if (mFrameCounter - mAgePedestrian > FEATURES_MAX_AGE)
-        mFeatures.pedestrians.clear();
-    if (mFrameCounter - mAgeVehicle > FEATURES_MAX_AGE)
-        mFeatures.vehicles.clear();
+    mTimeDraw += timeDelta();
+}
+
+// Draw a tracked object, labelled with its identifier, and where it is heading
+void MainWindow::drawObject(cv::Mat& iVisualisation, const TrackedObject& iObject, cv::Scalar iColour, int iThickness)
+{
+    cv::rectangle(iVisualisation, iObject.rect.tl(), iObject.rect.br(), iColour, iObject.confirmed ? iThickness : 1);
+
+    std::ostringstream tLabel;
+    tLabel << "#" << iObject.id;
+    if (iObject.distance > 0)
+        tLabel << " " << std::fixed << std::setprecision(1) << iObject.distance << " m";
+    cv::putText(iVisualisation, tLabel.str(), iObject.rect.tl() - cv::Point(0, 3), cv::FONT_HERSHEY_PLAIN, 1, iColour);
+
+    cv::Point tCenter(iObject.rect.x + iObject.rect.width/2, iObject.rect.y + iObject.rect.height/2);
+    cv::Point tHeading(cvRound(iObject.velocity.x * FEATURES_HEADING_FRAMES), cvRound(iObject.velocity.y * FEATURES_HEADING_FRAMES));
+    cv::line(iVisualisation, tCenter, tCenter + tHeading, iColour, 1);
 }
 
 void MainWindow::drawStats()
@@ -398,11 +473,12 @@ void MainWindow::drawStats()
     int mPreprocessDelta = 0, mTrackDelta = 0, mTramDelta = 0, mPedestriansDelta = 0, mVehicleDelta = 0, mTimeDelta = 0;
     if (mFrameCounter > 0)
     {
-        mPreprocessDelta = mTimePreprocess / mFrameCounter;
-        mTrackDelta = mTimeTrack / mFrameCounter;
-        mTramDelta = mTimeTram / mFrameCounter;
-        mPedestriansDelta = mTimePedestrians / mFrameCounter;
-        mVehicleDelta = mTimeVehicle / mFrameCounter;
+        const Pipeline::Timing& tTiming = mPipeline.timing();
+        mPreprocessDelta = tTiming.preprocess / mFrameCounter;
+        mTrackDelta = tTiming.track / mFrameCounter;
+        mTramDelta = tTiming.tram / mFrameCounter;
+        mPedestriansDelta = tTiming.pedestrians / mFrameCounter;
+        mVehicleDelta = tTiming.vehicles / mFrameCounter;
         mTimeDelta = mTimeDraw / mFrameCounter;
     }
     mUI->lblPreprocess->setText("Preprocess: " + QString::number(mPreprocessDelta) + " ms");
@@ -411,6 +487,28 @@ void MainWindow::drawStats()
     mUI->lblPedestrian->setText("Pedestrian: " + QString::number(mPedestriansDelta) + " ms");
     mUI->lblVehicle->setText("Vehicle: " + QString::number(mVehicleDelta) + " ms");
     mUI->lblDraw->setText("Draw: " + QString::number(mTimeDelta) + " ms");
+    if (mPipeline.scheduler().realtime())
+        mUI->lblRealtime->setText("Skipped: " + QString::number(mFramesSkipped) + " frames, "
+                                  + QString::number(mPipeline.scheduler().skipped(STAGE_PEDESTRIAN)) + " pedestrian and "
+                                  + QString::number(mPipeline.scheduler().skipped(STAGE_VEHICLE)) + " vehicle runs");
+    else
+        mUI->lblRealtime->setText("Not real-time");
+    const GroundPlane& tGroundPlane = mPipeline.groundPlane();
+    if (tGroundPlane.calibrating())
+        mUI->lblCalibration->setText("Calibrating: " + QString::number(tGroundPlane.progress()) + "%");
+    else
+        mUI->lblCalibration->setText("Camera at " + QString::number(tGroundPlane.height(), 'f', 2) + " m, pitched "
+                                     + QString::number(tGroundPlane.pitch() * 180 / CV_PI, 'f', 1) + " degrees");
+    if (mFrameGrabber.isOpen())
+        mUI->lblLatency->setText("Latency: " + QString::number(mLatency) + " ms, "
+                                 + QString::number(mFrameCounter > 0 ? mLatencyTotal / mFrameCounter : 0) + " ms average, "
+                                 + QString::number(mFrameGrabber.dropped()) + " frames dropped");
+    else
+        mUI->lblLatency->setText("Not live");
+    if (mVideoRecorder.isRecording())
+        mUI->lblRecord->setText("Recording: " + QString::number(mVideoRecorder.pending()) + " queued, " + QString::number(mVideoRecorder.dropped()) + " dropped");
+    else
+        mUI->lblRecord->setText("Not recording");
 }
 
 
@@ -467,6 +565,13 @@ void MainWindow::setTitle(QString iFilename)
 
 }
 
+// Align the playback clock with the current position in the video
+void MainWindow::restartPlayback()
+{
+    mPlaybackOrigin = mFramePosition;
+    mPlaybackClock.start();
+}
+
 void MainWindow::timeStart()
 {
     mTime = QDateTime::currentMSecsSinceEpoch();
@@ -15,9 +15,10 @@
 #include <QTime>
 #include "framefeatures.h"
 #include "featureexception.h"
-
-// Definitions
-#define WRITE_VIDEO 0
+#include "videorecorder.h"
+#include "framegrabber.h"
+#include "resources.h"
+#include "pipeline.h"
 
 // Enumerations
 enum Visualisation {
@@ -46,15 +47,24 @@ public:
 private slots:
     void on_btnStart_clicked();
     void on_btnStop_clicked();
+    void on_chkRealtime_toggled(bool iChecked);
     void on_actOpen_triggered();
+    void on_actOpenStream_triggered();
     void on_actRecentFile_triggered();
+    void on_actRecord_toggled(bool iChecked);
+    void on_actCalibrate_triggered();
 
     // File and video processing
 private slots:
     bool openFile(QString iFilename);
+    bool openStream(QString iSource);
+    void closeInput();
+    void resetInput(double iFps);
     void process();
-    void processFrame(cv::Mat& iFrame);
+    void processLive();
+    void processFrame(cv::Mat& iFrame, unsigned long iFrameNumber, double iTimestamp);
     void drawStats();
+    void drawObject(cv::Mat& iVisualisation, const TrackedObject& iObject, cv::Scalar iColour, int iThickness);
 
     // Auxiliary
 private slots:
@@ -64,15 +74,15 @@ private slots:
     void setTitle(QString iFilename = "");
     unsigned long timeDelta();
     void timeStart();
+    void restartPlayback();
 
 private:
     // Member data
     QTime mTimer;
     GLWidget* mGLWidget;
     cv::VideoCapture* mVideoCapture;
-#if WRITE_VIDEO
-    cv::VideoWriter* mVideoWriter;
-#endif
+    FrameGrabber mFrameGrabber;
+    VideoRecorder mVideoRecorder;
     QSettings* mSettings;
 
     // UI members
@@ -84,10 +94,17 @@ private:
 
     // Detection state
     bool mProcessing;
-    FrameFeatures mFeatures;
+    Resources mResources;
+    Pipeline mPipeline;
     unsigned int mFrameCounter;
-    unsigned long mTime, mTimePreprocess, mTimeTrack, mTimeTram, mTimeDistance, mTimePedestrians, mTimeVehicle, mTimeDraw;
-    unsigned int mAgeTrack, mAgeTram, mAgePedestrian, mAgeVehicle;
+    unsigned long mTime, mTimeDraw;
+
+    // Real-time playback
+    QTime mPlaybackClock;
+    unsigned long mFramePosition, mPlaybackOrigin, mFramesSkipped;
+
+    // Live latency, from capture to result
+    qint64 mLatency, mLatencyTotal;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,338 @@
+//
+// Configuration
+//
+
+// Includes
+#include "metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include "logger.h"
+
+// Exporter properties
+#define METRICS_POLL_INTERVAL 200       // between checks for a connection, in milliseconds
+#define METRICS_REQUEST_TIMEOUT 1000    // for a client to send its request, in milliseconds
+
+// Upper bounds of the histogram buckets, in milliseconds
+static const double gBuckets[METRICS_BUCKETS] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+
+//
+// Metrics
+//
+
+void Metrics::Counter::add(quint64 iAmount)
+{
+    QMutexLocker tLocker(&mMutex);
+    mValue += iAmount;
+}
+
+quint64 Metrics::Counter::value()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mValue;
+}
+
+void Metrics::Gauge::set(double iValue)
+{
+    QMutexLocker tLocker(&mMutex);
+    mValue = iValue;
+}
+
+double Metrics::Gauge::value()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mValue;
+}
+
+Metrics::Histogram::Histogram() : mCount(0), mSum(0)
+{
+    for (int i = 0; i < METRICS_BUCKETS; i++)
+        mBuckets[i] = 0;
+}
+
+// Only the first bucket which fits gets counted, the exposition adds them up
+void Metrics::Histogram::observe(double iValue)
+{
+    QMutexLocker tLocker(&mMutex);
+    for (int i = 0; i < METRICS_BUCKETS; i++)
+    {
+        if (iValue <= gBuckets[i])
+        {
+            mBuckets[i]++;
+            break;
+        }
+    }
+    mCount++;
+    mSum += iValue;
+}
+
+
+//
+// Construction and destruction
+//
+
+Metrics::Metrics()
+{
+}
+
+
+//
+// Registration
+//
+
+// Find or create the metric of a family with the given labels (as formatted
+// by label(), separated by commas). A name keeps the type it was first
+// registered with.
+Metrics::Counter* Metrics::counter(const std::string& iName, const std::string& iHelp, const std::string& iLabels)
+{
+    QMutexLocker tLocker(&mMutex);
+    Counter*& tCounter = family(iName, iHelp, COUNTER).counters[iLabels];
+    if (tCounter == 0)
+        tCounter = new Counter();
+    return tCounter;
+}
+
+Metrics::Gauge* Metrics::gauge(const std::string& iName, const std::string& iHelp, const std::string& iLabels)
+{
+    QMutexLocker tLocker(&mMutex);
+    Gauge*& tGauge = family(iName, iHelp, GAUGE).gauges[iLabels];
+    if (tGauge == 0)
+        tGauge = new Gauge();
+    return tGauge;
+}
+
+Metrics::Histogram* Metrics::histogram(const std::string& iName, const std::string& iHelp, const std::string& iLabels)
+{
+    QMutexLocker tLocker(&mMutex);
+    Histogram*& tHistogram = family(iName, iHelp, HISTOGRAM).histograms[iLabels];
+    if (tHistogram == 0)
+        tHistogram = new Histogram();
+    return tHistogram;
+}
+
+// Format a label, escaping its value
+std::string Metrics::label(const std::string& iName, const std::string& iValue)
+{
+    std::string tLabel = iName + "=\"";
+    for (size_t i = 0; i < iValue.size(); i++)
+    {
+        switch (iValue[i])
+        {
+        case '\\':
+            tLabel += "\\\\";
+            break;
+        case '"':
+            tLabel += "\\\"";
+            break;
+        case '\n':
+            tLabel += "\\n";
+            break;
+        default:
+            tLabel += iValue[i];
+        }
+    }
+    return tLabel + "\"";
+}
+
+
+//
+// Output
+//
+
+// Current value of every metric, in the Prometheus text format
+std::string Metrics::exposition()
+{
+    QMutexLocker tLocker(&mMutex);
+    std::ostringstream tOutput;
+    tOutput.precision(10);
+    for (std::map<std::string, Family>::iterator tFamily = mFamilies.begin(); tFamily != mFamilies.end(); ++tFamily)
+    {
+        const std::string& tName = tFamily->first;
+        tOutput << "# HELP " << tName << " " << tFamily->second.help << "\n";
+        switch (tFamily->second.type)
+        {
+        case COUNTER:
+            tOutput << "# TYPE " << tName << " counter\n";
+            for (std::map<std::string, Counter*>::iterator it = tFamily->second.counters.begin(); it != tFamily->second.counters.end(); ++it)
+                tOutput << tName << (it->first.empty() ? "" : "{" + it->first + "}") << " " << it->second->value() << "\n";
+            break;
+        case GAUGE:
+            tOutput << "# TYPE " << tName << " gauge\n";
+            for (std::map<std::string, Gauge*>::iterator it = tFamily->second.gauges.begin(); it != tFamily->second.gauges.end(); ++it)
+                tOutput << tName << (it->first.empty() ? "" : "{" + it->first + "}") << " " << it->second->value() << "\n";
+            break;
+        case HISTOGRAM:
+            tOutput << "# TYPE " << tName << " histogram\n";
+            for (std::map<std::string, Histogram*>::iterator it = tFamily->second.histograms.begin(); it != tFamily->second.histograms.end(); ++it)
+            {
+                std::string tLabels = it->first.empty() ? "" : it->first + ",";
+                Histogram& tHistogram = *it->second;
+                QMutexLocker tHistogramLocker(&tHistogram.mMutex);
+                quint64 tCumulative = 0;
+                for (int i = 0; i < METRICS_BUCKETS; i++)
+                {
+                    tCumulative += tHistogram.mBuckets[i];
+                    tOutput << tName << "_bucket{" << tLabels << "le=\"" << gBuckets[i] << "\"} " << tCumulative << "\n";
+                }
+                tOutput << tName << "_bucket{" << tLabels << "le=\"+Inf\"} " << tHistogram.mCount << "\n";
+                tOutput << tName << "_sum" << (it->first.empty() ? "" : "{" + it->first + "}") << " " << tHistogram.mSum << "\n";
+                tOutput << tName << "_count" << (it->first.empty() ? "" : "{" + it->first + "}") << " " << tHistogram.mCount << "\n";
+            }
+            break;
+        }
+    }
+    return tOutput.str();
+}
+
+
+//
+// Registry of the process
+//
+
+// Like the logger, the registry never gets destroyed, as threads may still
+// be updating metrics while the process exits
+Metrics& Metrics::instance()
+{
+    static Metrics* tMetrics = new Metrics();
+    return *tMetrics;
+}
+
+
+//
+// Auxiliary
+//
+
+Metrics::Family& Metrics::family(const std::string& iName, const std::string& iHelp, Type iType)
+{
+    std::map<std::string, Family>::iterator tFamily = mFamilies.find(iName);
+    if (tFamily == mFamilies.end())
+    {
+        Family tNew;
+        tNew.help = iHelp;
+        tNew.type = iType;
+        tFamily = mFamilies.insert(std::make_pair(iName, tNew)).first;
+    }
+    return tFamily->second;
+}
+
+
+//
+// Exporter
+//
+
+MetricsExporter::MetricsExporter(Metrics& iMetrics) : mMetrics(iMetrics), mPort(0), mInterval(0), mStopping(false)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+// Serve the metrics over HTTP on a local port (0 to not serve them)
+void MetricsExporter::setPort(quint16 iPort)
+{
+    mPort = iPort;
+}
+
+// Rewrite a file with the metrics every interval (in milliseconds)
+void MetricsExporter::setFile(const QString& iPath, int iInterval)
+{
+    mPath = iPath;
+    mInterval = iInterval;
+}
+
+// Write the file one last time, and stop the export thread
+void MetricsExporter::stop()
+{
+    mStopping = true;
+    wait();
+}
+
+
+//
+// Export thread
+//
+
+void MetricsExporter::run()
+{
+    // Sockets belong to the thread creating them
+    QTcpServer tServer;
+    if (mPort != 0 && !tServer.listen(QHostAddress::LocalHost, mPort))
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not serve metrics on port {}: {}", (int) mPort, tServer.errorString().toStdString());
+
+    QElapsedTimer tClock;
+    tClock.start();
+    while (!mStopping)
+    {
+        if (!mPath.isEmpty() && tClock.elapsed() >= mInterval)
+        {
+            dump();
+            tClock.restart();
+        }
+
+        if (!tServer.isListening())
+        {
+            msleep(METRICS_POLL_INTERVAL);
+            continue;
+        }
+        if (!tServer.waitForNewConnection(METRICS_POLL_INTERVAL))
+            continue;
+
+        // Answer a single request per connection
+        QTcpSocket* tSocket = tServer.nextPendingConnection();
+        QByteArray tRequest;
+        while (!tRequest.contains("\r\n\r\n") && tSocket->waitForReadyRead(METRICS_REQUEST_TIMEOUT))
+            tRequest += tSocket->readAll();
+        if (tRequest.startsWith("GET /metrics ") || tRequest.startsWith("GET / "))
+        {
+            std::string tBody = mMetrics.exposition();
+            std::ostringstream tResponse;
+            tResponse << "HTTP/1.0 200 OK\r\n"
+                      << "Content-Type: text/plain; version=0.0.4\r\n"
+                      << "Content-Length: " << tBody.size() << "\r\n"
+                      << "Connection: close\r\n\r\n"
+                      << tBody;
+            tSocket->write(tResponse.str().data(), tResponse.str().size());
+        }
+        else
+            tSocket->write("HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        tSocket->waitForBytesWritten(METRICS_REQUEST_TIMEOUT);
+        tSocket->disconnectFromHost();
+        if (tSocket->state() != QAbstractSocket::UnconnectedState)
+            tSocket->waitForDisconnected(METRICS_REQUEST_TIMEOUT);
+        delete tSocket;
+    }
+
+    if (!mPath.isEmpty())
+        dump();
+}
+
+
+//
+// Auxiliary
+//
+
+// Write the file next to its destination, and move it in place at once
+void MetricsExporter::dump()
+{
+    std::string tPath = mPath.toStdString();
+    std::string tTemporary = tPath + ".tmp";
+    {
+        std::ofstream tFile(tTemporary.c_str());
+        tFile << mMetrics.exposition();
+        if (!tFile)
+        {
+            Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not write metrics to {}", tTemporary);
+            return;
+        }
+    }
+    if (std::rename(tTemporary.c_str(), tPath.c_str()) != 0)
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not replace {}", tPath);
+}
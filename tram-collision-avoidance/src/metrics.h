@@ -0,0 +1,150 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef METRICS_H
+#define METRICS_H
+
+// Includes
+#include <string>
+#include <map>
+#include <QtGlobal>
+#include <QMutex>
+#include <QThread>
+#include <QString>
+
+// Buckets of the histograms, in milliseconds
+#define METRICS_BUCKETS 10
+
+/*
+  The Metrics registry keeps the counters, gauges and histograms through
+  which the process reports on itself while it runs, without an interface:
+  frames processed and dropped, detections, reasons why features weren't
+  found, queue depths and latencies. Every metric belongs to a family (its
+  name), and is told apart from the others of its family by its labels
+  (e.g. the stream it measures).
+
+  Metrics get looked up once and updated through the pointer, which stays
+  valid for the lifetime of the process. Updating only takes the lock of
+  the metric itself, so the threads of different streams don't contend.
+  The registry gets written out in the Prometheus text format.
+  */
+class Metrics
+{
+public:
+    // Value which only goes up
+    class Counter
+    {
+    public:
+        Counter() : mValue(0) {}
+        void add(quint64 iAmount = 1);
+        quint64 value();
+    private:
+        QMutex mMutex;
+        quint64 mValue;
+    };
+
+    // Value which gets set to the current state
+    class Gauge
+    {
+    public:
+        Gauge() : mValue(0) {}
+        void set(double iValue);
+        double value();
+    private:
+        QMutex mMutex;
+        double mValue;
+    };
+
+    // Distribution of durations, in milliseconds
+    class Histogram
+    {
+    public:
+        Histogram();
+        void observe(double iValue);
+    private:
+        friend class Metrics;
+        QMutex mMutex;
+        quint64 mBuckets[METRICS_BUCKETS];
+        quint64 mCount;
+        double mSum;
+    };
+
+    // Construction and destruction
+    Metrics();
+
+    // Registration
+    Counter* counter(const std::string& iName, const std::string& iHelp, const std::string& iLabels = "");
+    Gauge* gauge(const std::string& iName, const std::string& iHelp, const std::string& iLabels = "");
+    Histogram* histogram(const std::string& iName, const std::string& iHelp, const std::string& iLabels = "");
+    static std::string label(const std::string& iName, const std::string& iValue);
+
+    // Output
+    std::string exposition();
+
+    // Registry of the process
+    static Metrics& instance();
+
+private:
+    // Metrics sharing a name
+    enum Type { COUNTER, GAUGE, HISTOGRAM };
+    struct Family
+    {
+        std::string help;
+        Type type;
+        std::map<std::string, Counter*> counters;
+        std::map<std::string, Gauge*> gauges;
+        std::map<std::string, Histogram*> histograms;
+    };
+
+    // Auxiliary
+    Family& family(const std::string& iName, const std::string& iHelp, Type iType);
+
+    // Member data
+    QMutex mMutex;
+    std::map<std::string, Family> mFamilies;
+
+    // Disable copying
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+};
+
+/*
+  The MetricsExporter makes the registry available outside of the process,
+  from a thread of its own: over HTTP on a local port (any request for
+  /metrics gets the current exposition), and by periodically rewriting a
+  file with it. A file gets replaced at once, so a reader never sees it
+  half written.
+  */
+class MetricsExporter : public QThread
+{
+public:
+    // Construction and destruction
+    MetricsExporter(Metrics& iMetrics);
+    ~MetricsExporter();
+
+    // Configuration
+    void setPort(quint16 iPort);
+    void setFile(const QString& iPath, int iInterval);
+
+    // Control
+    void stop();
+
+protected:
+    // Export thread
+    void run();
+
+private:
+    // Auxiliary
+    void dump();
+
+    // Member data
+    Metrics& mMetrics;
+    quint16 mPort;
+    QString mPath;
+    int mInterval;
+    volatile bool mStopping;
+};
+
+#endif // METRICS_H
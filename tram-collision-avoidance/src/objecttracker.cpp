@@ -0,0 +1,164 @@
+//
+// Configuration
+//
+
+// Includes
+#include "objecttracker.h"
+#include "auxiliary.h"
+#include <algorithm>
+
+// Tracking properties
+#define TRACKER_ALPHA 0.5           // weight of a measured position
+#define TRACKER_BETA 0.2            // weight of a measured velocity
+#define TRACKER_MIN_OVERLAP 0.2     // intersection over union for a match
+#define TRACKER_CONFIRM_HITS 3      // detections before an object is confirmed
+#define TRACKER_MAX_MISSES 3        // detector runs an object may go unseen
+#define TRACKER_MAX_COAST 2         // detector runs in a row which may be skipped
+
+
+//
+// Construction and destruction
+//
+
+ObjectTracker::ObjectTracker()
+{
+    reset();
+}
+
+
+//
+// Tracking
+//
+
+void ObjectTracker::reset()
+{
+    mStates.clear();
+    mNextId = 1;
+    mFrame = 0;
+    mCoasted = 0;
+}
+
+// Move all objects to where they should be in the given frame
+void ObjectTracker::predict(unsigned long iFrame)
+{
+    if (iFrame > mFrame)
+    {
+        float tFrames = iFrame - mFrame;
+        for (size_t i = 0; i < mStates.size(); i++)
+            mStates[i].center += mStates[i].velocity * tFrames;
+    }
+    mFrame = iFrame;
+}
+
+// Fold the results of a detector run into the objects
+void ObjectTracker::update(const std::vector<cv::Rect>& iDetections, unsigned long iFrame)
+{
+    predict(iFrame);
+    mCoasted = 0;
+
+    // Associate detections with the predicted objects
+    std::vector<std::vector<double> > tCost(mStates.size(), std::vector<double>(iDetections.size()));
+    for (size_t i = 0; i < mStates.size(); i++)
+    {
+        cv::Rect tPrediction = rect(mStates[i]);
+        for (size_t j = 0; j < iDetections.size(); j++)
+            tCost[i][j] = 1 - overlap_rects(tPrediction, iDetections[j]);
+    }
+    std::vector<int> tAssignment;
+    assign_hungarian(tCost, tAssignment);
+
+    // Correct the matched objects
+    std::vector<bool> tMatched(iDetections.size(), false);
+    std::vector<State> tStates;
+    for (size_t i = 0; i < mStates.size(); i++)
+    {
+        State tState = mStates[i];
+        int j = tAssignment[i];
+        if (j >= 0 && 1 - tCost[i][j] >= TRACKER_MIN_OVERLAP)
+        {
+            const cv::Rect& tDetection = iDetections[j];
+            cv::Point2f tMeasured(tDetection.x + tDetection.width/2.0f, tDetection.y + tDetection.height/2.0f);
+            cv::Point2f tResidual = tMeasured - tState.center;
+            float tFrames = std::max(1ul, iFrame - tState.updated);
+
+            tState.center += tResidual * TRACKER_ALPHA;
+            tState.velocity += tResidual * (TRACKER_BETA / tFrames);
+            tState.size.width += TRACKER_ALPHA * (tDetection.width - tState.size.width);
+            tState.size.height += TRACKER_ALPHA * (tDetection.height - tState.size.height);
+            tState.updated = iFrame;
+            tState.hits++;
+            tState.misses = 0;
+            tMatched[j] = true;
+        }
+        else if (++tState.misses > TRACKER_MAX_MISSES)
+            continue;
+        tStates.push_back(tState);
+    }
+
+    // Start new objects
+    for (size_t j = 0; j < iDetections.size(); j++)
+    {
+        if (tMatched[j])
+            continue;
+        State tState;
+        tState.id = mNextId++;
+        tState.center = cv::Point2f(iDetections[j].x + iDetections[j].width/2.0f, iDetections[j].y + iDetections[j].height/2.0f);
+        tState.velocity = cv::Point2f(0, 0);
+        tState.size = cv::Size2f(iDetections[j].width, iDetections[j].height);
+        tState.updated = iFrame;
+        tState.hits = 1;
+        tState.misses = 0;
+        tStates.push_back(tState);
+    }
+
+    mStates = tStates;
+}
+
+// Whether the predictions can stand in for a detector run
+bool ObjectTracker::confident() const
+{
+    if (mStates.empty() || mCoasted >= TRACKER_MAX_COAST)
+        return false;
+    for (size_t i = 0; i < mStates.size(); i++)
+    {
+        if (mStates[i].hits < TRACKER_CONFIRM_HITS || mStates[i].misses > 0)
+            return false;
+    }
+    return true;
+}
+
+// Register a detector run which got skipped in favour of the predictions
+void ObjectTracker::coast()
+{
+    mCoasted++;
+}
+
+
+//
+// Output
+//
+
+void ObjectTracker::objects(std::vector<TrackedObject>& oObjects) const
+{
+    oObjects.clear();
+    for (size_t i = 0; i < mStates.size(); i++)
+    {
+        TrackedObject tObject;
+        tObject.id = mStates[i].id;
+        tObject.rect = rect(mStates[i]);
+        tObject.velocity = mStates[i].velocity;
+        tObject.confirmed = mStates[i].hits >= TRACKER_CONFIRM_HITS;
+        oObjects.push_back(tObject);
+    }
+}
+
+
+//
+// Auxiliary
+//
+
+cv::Rect ObjectTracker::rect(const State& iState) const
+{
+    return cv::Rect(cvRound(iState.center.x - iState.size.width/2), cvRound(iState.center.y - iState.size.height/2),
+                    cvRound(iState.size.width), cvRound(iState.size.height));
+}
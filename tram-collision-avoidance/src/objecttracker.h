@@ -0,0 +1,61 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef OBJECTTRACKER_H
+#define OBJECTTRACKER_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include "framefeatures.h"
+
+/*
+  The ObjectTracker follows the objects found by a detector across frames.
+  Every object moves at a constant velocity, filtered with an alpha-beta
+  filter, which predicts where it will be in the next frame. Detections are
+  associated with those predictions by maximizing their total overlap
+  (Hungarian method). Unmatched detections start new objects, and objects
+  which aren't found for a few detector runs get dropped.
+
+  Positions are in input frame coordinates, velocities in pixels per video
+  frame. Once all objects are confirmed and recently seen, the tracker is
+  confident enough to let the detector skip a few frames.
+  */
+class ObjectTracker
+{
+public:
+    // Construction and destruction
+    ObjectTracker();
+
+    // Tracking
+    void reset();
+    void predict(unsigned long iFrame);
+    void update(const std::vector<cv::Rect>& iDetections, unsigned long iFrame);
+    bool confident() const;
+    void coast();
+
+    // Output
+    void objects(std::vector<TrackedObject>& oObjects) const;
+
+private:
+    // Object state
+    struct State
+    {
+        unsigned int id;
+        cv::Point2f center, velocity;
+        cv::Size2f size;
+        unsigned long updated;
+        unsigned int hits, misses;
+    };
+    cv::Rect rect(const State& iState) const;
+
+    // Member data
+    std::vector<State> mStates;
+    unsigned int mNextId;
+    unsigned long mFrame;
+    unsigned int mCoasted;
+};
+
+#endif // OBJECTTRACKER_H
@@ -4,13 +4,18 @@
 
 // Includes
 #include "pedestriandetection.h"
+#include <algorithm>
+#include "framearena.h"
+
+// Feature properties
+#define PEDESTRIAN_WORKING_HEIGHT 190
 
 
 //
 // Construction and destruction
 //
 
-PedestrianDetection::PedestrianDetection(cv::Mat const* iFrame) : Component(iFrame)
+PedestrianDetection::PedestrianDetection(FrameContext* iContext, cv::CascadeClassifier* iCascade, double iDetail) : Component(iContext, PEDESTRIAN_WORKING_HEIGHT, iDetail), mCascade(iCascade)
 {
     adjustedX = 0;
     tracksWidth = -1;
@@ -23,36 +28,34 @@ PedestrianDetection::PedestrianDetection(cv::Mat const* iFrame) : Component(iFra
 
 void PedestrianDetection::preprocess()
 {
-    mFrameDebug = (*frame()).clone();
+    debug().setBackground(*frame());
 
     enhanceFrame();
 }
 
-void PedestrianDetection::find_features(FrameFeatures& iFrameFeatures) throw(FeatureException)
+FeatureStatus PedestrianDetection::find_features(FrameFeatures& iFrameFeatures)
 {
     //Detecting current tracks width
     if (iFrameFeatures.tracks.first.size() > 1 && iFrameFeatures.tracks.second.size() > 1) {
-        int x1 = iFrameFeatures.tracks.first[0].x;
-        int y1 = iFrameFeatures.tracks.first[0].y;
-        int x2 = iFrameFeatures.tracks.second[0].x;
-        int y2 = iFrameFeatures.tracks.second[0].y;
+        cv::Point tFirst = toWorking(iFrameFeatures.tracks.first[0]);
+        cv::Point tSecond = toWorking(iFrameFeatures.tracks.second[0]);
+        int x1 = tFirst.x;
+        int y1 = tFirst.y;
+        int x2 = tSecond.x;
+        int y2 = tSecond.y;
 
         tracksWidth = sqrt(pow(x2-x1, 2) + pow(y2-y1, 2));
         tracksStartCol = x1;
         tracksEndCol = x2;
     }
+    //Region around the path of the tram, if we know it
+    mCorridor = cv::Rect(toWorking(iFrameFeatures.corridorBounds.tl()), toWorking(iFrameFeatures.corridorBounds.br()));
     //Crop the frame = faster detection
     cropFrame();
     //Detect pedestrians
-    detectPedestrians(iFrameFeatures);
-}
-
-cv::Mat PedestrianDetection::frameDebug() const
-{
-    return mFrameDebug;
+    return detectPedestrians(iFrameFeatures);
 }
 
-
 //
 // Feature detection
 //
@@ -62,7 +65,10 @@ void PedestrianDetection::cropFrame()
     //Only interested in the area next to the tracks
     cv::Range rowRange(0, frame()->rows);
     cv::Range colRange;
-    if (tracksWidth > -1) {
+    if (mCorridor.width > 0 && mCorridor.x < frame()->cols) {
+        adjustedX = std::max(0, mCorridor.x);
+        colRange = cv::Range(adjustedX, std::min(frame()->cols, mCorridor.x + mCorridor.width));
+    } else if (tracksWidth > -1) {
         adjustedX = tracksStartCol - 2*tracksWidth;
         if (adjustedX < 0) {
             adjustedX = 0;
@@ -71,12 +77,9 @@ void PedestrianDetection::cropFrame()
     } else {
         colRange = cv::Range(0, frame()->cols);
     }
-    cv::Mat blockFromFrame(*frame(), rowRange, colRange);
-
-    //Scaling it down to 190x[x]
-    scale = blockFromFrame.rows / 190;
-    mFrameCropped = cv::Mat(blockFromFrame.rows / scale, blockFromFrame.cols / scale, CV_8UC3);
-    cv::resize(blockFromFrame, mFrameCropped, mFrameCropped.size(), 0, 0, cv::INTER_LINEAR);
+    //The frame already got scaled down to 190x[x], and the classifier
+    //works on grayscale images anyway
+    mFrameCropped = cv::Mat(frameGray(), rowRange, colRange);
 }
 
 void PedestrianDetection::enhanceFrame()
@@ -101,15 +104,15 @@ void PedestrianDetection::enhanceFrame()
     //        GaussianBlur(dst, dst, Size(5, 5), 1.2, 1.2);
 }
 
-void PedestrianDetection::detectPedestrians(FrameFeatures& iFrameFeatures)
+FeatureStatus PedestrianDetection::detectPedestrians(FrameFeatures& iFrameFeatures)
 {
     bool added = false;
-    std::vector<cv::Rect> found_filtered;
+    ArenaVector<cv::Rect>::type found_filtered;
     std::vector<cv::Rect> found;
-    //Loading cascade xml
-    if (!cascade.load("./res/haarcascade_fullbody.xml"))
-        throw FeatureException("Could not load cascade definition file");
-    cascade.detectMultiScale(mFrameCropped, found);
+    //The cascade gets loaded once per thread
+    if (mCascade == 0)
+        return FeatureStatus(REASON_NO_RESOURCE, "Could not load cascade definition file");
+    mCascade->detectMultiScale(mFrameCropped, found);
 
     size_t j;
     //Find the rect's found for the people
@@ -126,24 +129,21 @@ void PedestrianDetection::detectPedestrians(FrameFeatures& iFrameFeatures)
     for(size_t i = 0; i < found_filtered.size(); i++ )
     {
         cv::Rect r = found_filtered[i];
-        r.x *= scale;
         r.x += adjustedX;
-        r.y *= scale;
-        r.width *= scale;
-        r.height *= scale;
 
         if (!added) {
             iFrameFeatures.pedestrians.clear();
         }
 
-        iFrameFeatures.pedestrians.push_back(r);
+        iFrameFeatures.pedestrians.push_back(toInput(r));
 
         added = true;
 
-        cv::rectangle(mFrameDebug, r.tl(), r.br(), cv::Scalar(0,0,255), 2);
+        debug().rectangle(r.tl(), r.br(), cv::Scalar(0,0,255), 2);
     }
-    //If no features are found: exception
+    //If no features are found: say so
     if (!added) {
-        throw FeatureException("no pedestrians found");
+        return FeatureStatus(REASON_NOT_FOUND, "no pedestrians found");
     }
+    return FeatureStatus::found();
 }
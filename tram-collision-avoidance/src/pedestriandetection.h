@@ -19,28 +19,26 @@ class PedestrianDetection : public Component
 {
 public:
     // Construction and destruction
-    PedestrianDetection(cv::Mat const* iFrame);
+    PedestrianDetection(FrameContext* iContext, cv::CascadeClassifier* iCascade, double iDetail = 1.0);
 
     // Component interface
     void preprocess();
-    void find_features(FrameFeatures& iFrameFeatures) throw(FeatureException);
-    cv::Mat frameDebug() const;
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
 
 private:
     // Feature detection
-    cv::CascadeClassifier cascade;
-    int scale;
+    cv::CascadeClassifier* mCascade;
     int tracksWidth, tracksStartCol, tracksEndCol;
     int adjustedX;
 
     void cropFrame();
     void enhanceFrame();
-    void detectPedestrians(FrameFeatures& iFrameFeatures);
+    FeatureStatus detectPedestrians(FrameFeatures& iFrameFeatures);
 
     cv::Mat mFrameCropped;
+    cv::Rect mCorridor;
 
     // Frames
     cv::Mat mFramePreprocessed;
-    cv::Mat mFrameDebug;
 };
 #endif // PEDESTRIANDETECTION_H
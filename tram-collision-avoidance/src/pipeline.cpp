@@ -0,0 +1,447 @@
+//
+// Configuration
+//
+
+// Includes
+#include "pipeline.h"
+#include <QDateTime>
+#include "trackdetection.h"
+#include "tramdetection.h"
+#include "tramdistance.h"
+#include "pedestriandetection.h"
+#include "vehicledetection.h"
+#include "timetocollision.h"
+#include "collisionrisk.h"
+#include "framearena.h"
+#include "alertoutput.h"
+
+// Definitions
+#define FEATURES_MAX_AGE 10             // in video frames
+#define FEATURES_CONFIDENCE_DECAY 0.8   // per frame a feature isn't refreshed
+
+// Names of the stages, in order of the enumeration
+static const char* gStageNames[] = { "track", "tram", "distance", "pedestrian", "vehicle" };
+
+
+//
+// Construction and destruction
+//
+
+Pipeline::Pipeline(const Resources* iResources, const std::string& iName, unsigned int iStream) : mResources(iResources), mStream(iStream)
+{
+    reset(0);
+
+    // Look up the metrics once, only the reasons for missing features get
+    // registered as they occur
+    Metrics& tMetrics = Metrics::instance();
+    mLabels = Metrics::label("stream", iName);
+    mFramesMetric = tMetrics.counter("tram_frames_processed_total", "Frames processed.", mLabels);
+    mFrameMetric = tMetrics.histogram("tram_frame_duration_ms", "Time spent processing a frame, in milliseconds.", mLabels);
+    mDroppedMetric = tMetrics.counter("tram_frames_dropped_total", "Live frames overwritten before being processed.", mLabels);
+    mLatencyMetric = tMetrics.histogram("tram_stream_latency_ms", "Time from a frame becoming available until its features, in milliseconds.", mLabels);
+    mPreprocessMetric = tMetrics.histogram("tram_stage_duration_ms", "Time spent per stage of a frame, in milliseconds.", mLabels + "," + Metrics::label("stage", "preprocess"));
+    for (int i = 0; i < STAGE_COUNT; i++)
+        mStageMetrics[i] = tMetrics.histogram("tram_stage_duration_ms", "Time spent per stage of a frame, in milliseconds.", mLabels + "," + Metrics::label("stage", gStageNames[i]));
+    mTracksMetric = tMetrics.counter("tram_detections_total", "Features found, per type.", mLabels + "," + Metrics::label("type", "track"));
+    mTramsMetric = tMetrics.counter("tram_detections_total", "Features found, per type.", mLabels + "," + Metrics::label("type", "tram"));
+    mPedestriansMetric = tMetrics.counter("tram_detections_total", "Features found, per type.", mLabels + "," + Metrics::label("type", "pedestrian"));
+    mVehiclesMetric = tMetrics.counter("tram_detections_total", "Features found, per type.", mLabels + "," + Metrics::label("type", "vehicle"));
+    mHazardsMetric = tMetrics.counter("tram_detections_total", "Features found, per type.", mLabels + "," + Metrics::label("type", "hazard"));
+    for (int i = 0; i < LOG_CATEGORIES; i++)
+        for (int j = 0; j < REASON_COUNT; j++)
+            mStatusMetrics[i][j] = 0;
+}
+
+
+//
+// Processing
+//
+
+// Start over with a new stream (at a frame rate of 0 if unknown)
+void Pipeline::reset(double iFps)
+{
+    mScheduler.setDeadline(1000.0 / (iFps > 0 ? iFps : 25));
+
+    // Reset features (and their age trackers)
+    mFeatures = FrameFeatures();
+    mPublisher.publish(mFeatures);
+    mTrackModel.reset();
+    mPedestrianTracker.reset();
+    mVehicleTracker.reset();
+    mGroundPlane.calibrate();
+
+    // Reset time counters
+    mFrames = 0;
+    mDroppedCounted = 0;
+    mTiming.preprocess = 0;
+    mTiming.track = 0;
+    mTiming.tram = 0;
+    mTiming.distance = 0;
+    mTiming.pedestrians = 0;
+    mTiming.vehicles = 0;
+}
+
+// Find the features of the next frame of the stream. The debug frame of the
+// requested component gets returned, unless it was skipped.
+void Pipeline::process(const cv::Mat& iFrame, unsigned long iFrameNumber, double iTimestamp, DebugView iDebug, cv::Mat& oDebug)
+{
+    mFeatures.frame = iFrameNumber;
+    mFeatures.timestamp = iTimestamp;
+    qint64 tFrameStart = QDateTime::currentMSecsSinceEpoch();
+
+    // Plan the frame
+    mScheduler.beginFrame(mFrames);
+    bool tRunTrack = mScheduler.admit(STAGE_TRACK);
+    bool tRunTram = mScheduler.admit(STAGE_TRAM);
+    bool tRunDistance = mScheduler.admit(STAGE_DISTANCE);
+    bool tRunPedestrians = mScheduler.admit(STAGE_PEDESTRIAN);
+    bool tRunVehicles = mScheduler.admit(STAGE_VEHICLE);
+
+    // Detectors whose objects are all being tracked reliably can take a break
+    if (tRunPedestrians && mPedestrianTracker.confident())
+    {
+        mPedestrianTracker.coast();
+        tRunPedestrians = false;
+    }
+    if (tRunVehicles && mVehicleTracker.confident())
+    {
+        mVehicleTracker.coast();
+        tRunVehicles = false;
+    }
+
+    // Load objects
+    FrameContext tContext(iFrame);
+    TrackDetection tTrackDetection(&tContext, &mTrackModel, &mHough);
+    TramDetection tTramDetection(&tContext, mResources->tramTemplate());
+    TramDistance tTramDistance(&tContext, &mGroundPlane);
+    TimeToCollision tTimeToCollision(&tContext);
+    CollisionRisk tCollisionRisk(&tContext);
+    PedestrianDetection tPedestrianDetection(&tContext, mResources->pedestrianCascade(), mScheduler.detail(STAGE_PEDESTRIAN));
+    VehicleDetection tVehicleDetection(&tContext, mScheduler.detail(STAGE_VEHICLE));
+
+    // Only the component whose debug frame gets shown records its overlay
+    Component* tDebugComponent = 0;
+    switch (iDebug)
+    {
+    case VIEW_NONE:
+        break;
+    case VIEW_TRACK:
+        tDebugComponent = &tTrackDetection;
+        break;
+    case VIEW_TRAM:
+        tDebugComponent = &tTramDetection;
+        break;
+    case VIEW_DISTANCE:
+        tDebugComponent = &tTramDistance;
+        break;
+    case VIEW_PEDESTRIAN:
+        tDebugComponent = &tPedestrianDetection;
+        break;
+    case VIEW_VEHICLE:
+        tDebugComponent = &tVehicleDetection;
+        break;
+    case VIEW_TIME_TO_COLLISION:
+        tDebugComponent = &tTimeToCollision;
+        break;
+    case VIEW_COLLISION_RISK:
+        tDebugComponent = &tCollisionRisk;
+        break;
+    }
+    if (tDebugComponent != 0)
+        tDebugComponent->setDebug(true);
+
+    // Preprocess
+    unsigned long tDelta;
+    timeStart();
+#pragma omp parallel sections
+    {
+#pragma omp section
+        {
+            if (tRunTrack)
+                tTrackDetection.preprocess();
+        }
+#pragma omp section
+        {
+            if (tRunTram)
+                tTramDetection.preprocess();
+        }
+#pragma omp section
+        {
+            if (tRunDistance)
+            {
+                tTramDistance.preprocess();
+                tTimeToCollision.preprocess();
+            }
+        }
+#pragma omp section
+        {
+            if (tRunPedestrians)
+                tPedestrianDetection.preprocess();
+        }
+#pragma omp section
+        {
+            if (tRunVehicles)
+                tVehicleDetection.preprocess();
+        }
+#pragma omp section
+        {
+            tCollisionRisk.preprocess();
+        }
+    }
+    tDelta = timeDelta();
+    mTiming.preprocess += tDelta;
+    mPreprocessMetric->observe(tDelta);
+
+    // Find features
+    timeStart();
+    FeatureStatus tStatus;
+    if (tRunTrack)
+    {
+        tStatus = tTrackDetection.find_features(mFeatures);
+        if (tStatus.ok())
+        {
+            mFeatures.tracksAge.update(mFeatures.frame, mFeatures.timestamp, 1);
+            mGroundPlane.observe(mFeatures.tracks, iFrame.size());
+            mTracksMetric->add();
+        }
+        else
+            report(LOG_TRACK, tStatus);
+        tDelta = timeDelta();
+        mTiming.track += tDelta;
+        mStageMetrics[STAGE_TRACK]->observe(tDelta);
+        mScheduler.finished(STAGE_TRACK, tDelta);
+    }
+    if (tRunTram)
+    {
+        tStatus = tTramDetection.find_features(mFeatures);
+        if (tStatus.ok())
+        {
+            mFeatures.tramAge.update(mFeatures.frame, mFeatures.timestamp, mFeatures.maxValue);
+            mTramsMetric->add();
+        }
+        else
+            report(LOG_TRAM, tStatus);
+        tDelta = timeDelta();
+        mTiming.tram += tDelta;
+        mStageMetrics[STAGE_TRAM]->observe(tDelta);
+        mScheduler.finished(STAGE_TRAM, tDelta);
+    }
+    if (tRunDistance)
+    {
+        tStatus = tTramDistance.find_features(mFeatures);
+        if (!tStatus.ok())
+            report(LOG_DISTANCE, tStatus);
+        tStatus = tTimeToCollision.find_features(mFeatures);
+        if (!tStatus.ok())
+            report(LOG_COLLISION, tStatus);
+        tDelta = timeDelta();
+        mTiming.distance += tDelta;
+        mStageMetrics[STAGE_DISTANCE]->observe(tDelta);
+        mScheduler.finished(STAGE_DISTANCE, tDelta);
+    }
+
+    // Lower priority detectors only run if they still fit in the deadline
+    // (a run which doesn't find anything still tells the tracker that the
+    // objects it follows have gone missing)
+    if (tRunPedestrians && mScheduler.admit(STAGE_PEDESTRIAN))
+    {
+        std::vector<cv::Rect> tDetections;
+        tStatus = tPedestrianDetection.find_features(mFeatures);
+        if (tStatus.ok())
+        {
+            mFeatures.pedestriansAge.update(mFeatures.frame, mFeatures.timestamp, 1);
+            tDetections = mFeatures.pedestrians;
+            mPedestriansMetric->add(tDetections.size());
+        }
+        else
+            report(LOG_PEDESTRIAN, tStatus);
+        mPedestrianTracker.update(tDetections, mFeatures.frame);
+        tDelta = timeDelta();
+        mTiming.pedestrians += tDelta;
+        mStageMetrics[STAGE_PEDESTRIAN]->observe(tDelta);
+        mScheduler.finished(STAGE_PEDESTRIAN, tDelta);
+    }
+    else
+        mPedestrianTracker.predict(mFeatures.frame);
+    mPedestrianTracker.objects(mFeatures.pedestrianObjects);
+    locate(mFeatures.pedestrianObjects);
+
+    if (tRunVehicles && mScheduler.admit(STAGE_VEHICLE))
+    {
+        std::vector<cv::Rect> tDetections;
+        tStatus = tVehicleDetection.find_features(mFeatures);
+        if (tStatus.ok())
+        {
+            mFeatures.vehiclesAge.update(mFeatures.frame, mFeatures.timestamp, 1);
+            tDetections = mFeatures.vehicles;
+            mVehiclesMetric->add(tDetections.size());
+        }
+        else
+            report(LOG_VEHICLE, tStatus);
+        mVehicleTracker.update(tDetections, mFeatures.frame);
+        tDelta = timeDelta();
+        mTiming.vehicles += tDelta;
+        mStageMetrics[STAGE_VEHICLE]->observe(tDelta);
+        mScheduler.finished(STAGE_VEHICLE, tDelta);
+    }
+    else
+        mVehicleTracker.predict(mFeatures.frame);
+    mVehicleTracker.objects(mFeatures.vehicleObjects);
+    locate(mFeatures.vehicleObjects);
+
+    // Combine everything into hazards, and have the detectors watch the
+    // ones near the tram every frame
+    tStatus = tCollisionRisk.find_features(mFeatures);
+    if (tStatus.ok())
+        mHazardsMetric->add(mFeatures.hazards.size());
+    else
+        report(LOG_COLLISION, tStatus);
+    bool tPedestrianHazard = false, tVehicleHazard = false;
+    for (size_t i = 0; i < mFeatures.hazards.size(); i++)
+    {
+        if (mFeatures.hazards[i].type == HAZARD_PEDESTRIAN)
+            tPedestrianHazard = true;
+        else if (mFeatures.hazards[i].type == HAZARD_VEHICLE)
+            tVehicleHazard = true;
+    }
+    mScheduler.setUrgent(STAGE_PEDESTRIAN, tPedestrianHazard);
+    mScheduler.setUrgent(STAGE_VEHICLE, tVehicleHazard);
+
+    // Skipped components have no debug frame
+    if (tDebugComponent != 0)
+        oDebug = tDebugComponent->frameDebug();
+    else
+        oDebug = cv::Mat();
+    mFrames++;
+
+    // Check for outdated features
+    if (age(mFeatures.tracksAge))
+    {
+        mFeatures.tracks.first.clear();
+        mFeatures.tracks.second.clear();
+    }
+    if (age(mFeatures.tramAge))
+    {
+        mFeatures.tram = cv::Rect();
+        mFeatures.tramScale = 1;
+    }
+    if (age(mFeatures.pedestriansAge))
+        mFeatures.pedestrians.clear();
+    if (age(mFeatures.vehiclesAge))
+        mFeatures.vehicles.clear();
+    mPublisher.publish(mFeatures);
+    AlertOutput::instance().publish(mStream, mFeatures);
+    mFramesMetric->add();
+    mFrameMetric->observe(QDateTime::currentMSecsSinceEpoch() - tFrameStart);
+
+    // All temporaries of the frame are gone by now
+    FrameArena::local().reset();
+}
+
+// Account for the capture of the frame just processed: the time from it
+// becoming available until its features (in milliseconds), and the frames
+// the source dropped so far, as a running total
+void Pipeline::reportCapture(qint64 iLatency, unsigned long iDropped)
+{
+    mLatencyMetric->observe(iLatency);
+    if (iDropped > mDroppedCounted)
+        mDroppedMetric->add(iDropped - mDroppedCounted);
+    mDroppedCounted = iDropped;
+}
+
+
+//
+// State
+//
+
+// Features being worked on, only to be used by the thread processing
+const FrameFeatures& Pipeline::features() const
+{
+    return mFeatures;
+}
+
+// Latest complete features, for any thread
+FeaturePublisher& Pipeline::publisher()
+{
+    return mPublisher;
+}
+
+Scheduler& Pipeline::scheduler()
+{
+    return mScheduler;
+}
+
+GroundPlane& Pipeline::groundPlane()
+{
+    return mGroundPlane;
+}
+
+
+//
+// Statistics
+//
+
+unsigned long Pipeline::frames() const
+{
+    return mFrames;
+}
+
+const Pipeline::Timing& Pipeline::timing() const
+{
+    return mTiming;
+}
+
+
+//
+// Feature bookkeeping
+//
+
+// Decay the confidence of a feature which wasn't refreshed this frame, and
+// check whether it has become too old to keep around
+bool Pipeline::age(FeatureAge& iAge)
+{
+    if (iAge.frame == mFeatures.frame)
+        return false;
+    iAge.confidence *= FEATURES_CONFIDENCE_DECAY;
+    return mFeatures.frame - iAge.frame > FEATURES_MAX_AGE;
+}
+
+// Find the distance to objects, from where they stand on the ground
+void Pipeline::locate(std::vector<TrackedObject>& iObjects)
+{
+    for (size_t i = 0; i < iObjects.size(); i++)
+    {
+        const cv::Rect& tRect = iObjects[i].rect;
+        iObjects[i].distance = mGroundPlane.distance(cv::Point(tRect.x + tRect.width/2, tRect.y + tRect.height));
+    }
+}
+
+// Log why a feature wasn't found, and count it
+void Pipeline::report(LogCategory iCategory, const FeatureStatus& iStatus)
+{
+    Logger::instance().status(iCategory, iStatus);
+
+    Metrics::Counter*& tMetric = mStatusMetrics[iCategory][iStatus.reason()];
+    if (tMetric == 0)
+        tMetric = Metrics::instance().counter("tram_feature_misses_total", "Features not found, per component and reason.",
+                                              mLabels + "," + Metrics::label("component", Logger::name(iCategory)) + "," + Metrics::label("reason", FeatureStatus::name(iStatus.reason())));
+    tMetric->add();
+}
+
+
+//
+// Auxiliary
+//
+
+void Pipeline::timeStart()
+{
+    mTime = QDateTime::currentMSecsSinceEpoch();
+}
+
+unsigned long Pipeline::timeDelta()
+{
+    qint64 tCurrentTime = QDateTime::currentMSecsSinceEpoch();
+    unsigned long tDelta = tCurrentTime - mTime;
+    mTime = tCurrentTime;
+    return tDelta;
+}
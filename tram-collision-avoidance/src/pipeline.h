@@ -0,0 +1,119 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include <string>
+#include "framefeatures.h"
+#include "resources.h"
+#include "scheduler.h"
+#include "trackmodel.h"
+#include "bandedhough.h"
+#include "objecttracker.h"
+#include "groundplane.h"
+#include "featurepublisher.h"
+#include "featurestatus.h"
+#include "logger.h"
+#include "metrics.h"
+
+// Enumerations
+enum DebugView {
+    VIEW_NONE = 0,
+    VIEW_TRACK,
+    VIEW_TRAM,
+    VIEW_DISTANCE,
+    VIEW_PEDESTRIAN,
+    VIEW_VEHICLE,
+    VIEW_TIME_TO_COLLISION,
+    VIEW_COLLISION_RISK
+};
+
+/*
+  The Pipeline runs all components on the frames of a single stream. It owns
+  everything which carries over from one frame to the next (the features,
+  the models and trackers, the ground plane and the scheduler), while the
+  read-only detector data comes from Resources which may be shared between
+  several pipelines. A pipeline is meant to be used by one thread at a time.
+
+  The features are worked on in place while processing a frame, and only
+  get published once the frame is complete: other threads read them
+  through the publisher, never through features().
+
+  Every pipeline reports on its frames through the metrics registry,
+  labelled with the name of its stream (along with the latency and dropped
+  frames of the capture, which its caller passes on), and sends the
+  features of every frame to the alert output as soon as they're complete.
+  */
+class Pipeline
+{
+public:
+    // Time spent per stage, in milliseconds
+    struct Timing
+    {
+        unsigned long preprocess, track, tram, distance, pedestrians, vehicles;
+    };
+
+    // Construction and destruction
+    Pipeline(const Resources* iResources, const std::string& iName = "main", unsigned int iStream = 0);
+
+    // Processing
+    void reset(double iFps);
+    void process(const cv::Mat& iFrame, unsigned long iFrameNumber, double iTimestamp, DebugView iDebug, cv::Mat& oDebug);
+    void reportCapture(qint64 iLatency, unsigned long iDropped);
+
+    // State
+    const FrameFeatures& features() const;
+    FeaturePublisher& publisher();
+    Scheduler& scheduler();
+    GroundPlane& groundPlane();
+
+    // Statistics
+    unsigned long frames() const;
+    const Timing& timing() const;
+
+private:
+    // Feature bookkeeping
+    bool age(FeatureAge& iAge);
+    void locate(std::vector<TrackedObject>& iObjects);
+    void report(LogCategory iCategory, const FeatureStatus& iStatus);
+
+    // Auxiliary
+    void timeStart();
+    unsigned long timeDelta();
+
+    // Member data
+    const Resources* mResources;
+    unsigned int mStream;
+    FrameFeatures mFeatures;
+    FeaturePublisher mPublisher;
+    TrackModel mTrackModel;
+    BandedHough mHough;
+    ObjectTracker mPedestrianTracker, mVehicleTracker;
+    GroundPlane mGroundPlane;
+    Scheduler mScheduler;
+
+    // Statistics
+    unsigned long mFrames;
+    Timing mTiming;
+    qint64 mTime;
+    unsigned long mDroppedCounted;
+
+    // Metrics
+    std::string mLabels;
+    Metrics::Counter* mFramesMetric;
+    Metrics::Histogram* mFrameMetric;
+    Metrics::Counter* mDroppedMetric;
+    Metrics::Histogram* mLatencyMetric;
+    Metrics::Histogram* mPreprocessMetric;
+    Metrics::Histogram* mStageMetrics[STAGE_COUNT];
+    Metrics::Counter *mTracksMetric, *mTramsMetric, *mPedestriansMetric, *mVehiclesMetric, *mHazardsMetric;
+    Metrics::Counter* mStatusMetrics[LOG_CATEGORIES][REASON_COUNT];
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,49 @@
+//
+// Configuration
+//
+
+// Includes
+#include "resources.h"
+#include "highgui.h"
+
+// Resource files
+#define RESOURCE_TRAM_TEMPLATE "../res/tram_back004.jpg"
+#define RESOURCE_PEDESTRIAN_CASCADE "./res/haarcascade_fullbody.xml"
+
+
+//
+// Construction and destruction
+//
+
+Resources::Resources()
+{
+    mTramTemplate = cv::imread(RESOURCE_TRAM_TEMPLATE);
+}
+
+
+//
+// Detector data
+//
+
+// The template of the back of a tram, at reference resolution (empty if it
+// couldn't be loaded)
+const cv::Mat& Resources::tramTemplate() const
+{
+    return mTramTemplate;
+}
+
+// The pedestrian cascade of the calling thread (0 if it couldn't be loaded)
+cv::CascadeClassifier* Resources::pedestrianCascade() const
+{
+    if (!mPedestrianCascades.hasLocalData())
+    {
+        cv::CascadeClassifier* tCascade = new cv::CascadeClassifier();
+        if (!tCascade->load(RESOURCE_PEDESTRIAN_CASCADE))
+        {
+            delete tCascade;
+            tCascade = 0;
+        }
+        mPedestrianCascades.setLocalData(tCascade);
+    }
+    return mPedestrianCascades.localData();
+}
@@ -0,0 +1,35 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+// Includes
+#include "opencv/cv.h"
+#include <QThreadStorage>
+
+/*
+  The Resources hold the read-only data the detectors need, so it only gets
+  loaded once no matter how many streams get processed: the tram template
+  is shared as is. The pedestrian cascade isn't safe to use from several
+  threads at once, so every thread loads its own copy, once, on first use.
+  */
+class Resources
+{
+public:
+    // Construction and destruction
+    Resources();
+
+    // Detector data
+    const cv::Mat& tramTemplate() const;
+    cv::CascadeClassifier* pedestrianCascade() const;
+
+private:
+    // Member data
+    cv::Mat mTramTemplate;
+    mutable QThreadStorage<cv::CascadeClassifier*> mPedestrianCascades;
+};
+
+#endif // RESOURCES_H
@@ -0,0 +1,223 @@
+//
+// Configuration
+//
+
+// Includes
+#include "scheduler.h"
+#include <algorithm>
+
+// Scheduling properties
+#define COST_SMOOTHING 0.2          // weight of a new cost measurement
+#define COST_DECAY 0.9              // decay of the estimate of a skipped stage
+#define DETAIL_STEP 0.75
+#define DETAIL_MIN 0.5
+#define DETAIL_RECOVER 0.5          // fraction of the budget below which detail gets restored
+
+
+//
+// Construction and destruction
+//
+
+Scheduler::Scheduler() : mRealtime(false), mDeadline(40)
+{
+    // Stages in order of priority: tracks are needed by everything else,
+    // and the distance estimation is almost free
+    const bool tMandatory[STAGE_COUNT] = { true, true, true, false, false };
+    const double tBudget[STAGE_COUNT] = { 0.35, 0.15, 0.05, 0.25, 0.20 };
+    const unsigned int tPeriod[STAGE_COUNT] = { 1, 1, 1, 2, 4 };
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        mStages[i].mandatory = tMandatory[i];
+        mStages[i].budget = tBudget[i];
+        mStages[i].cost = 0;
+        mStages[i].detail = 1;
+        mStages[i].period = tPeriod[i];
+        mStages[i].phase = 0;
+        mStages[i].urgent = false;
+        mStages[i].planned = true;
+        mStages[i].skipped = 0;
+    }
+    stagger();
+}
+
+
+//
+// Configuration
+//
+
+void Scheduler::setRealtime(bool iRealtime)
+{
+    mRealtime = iRealtime;
+}
+
+bool Scheduler::realtime() const
+{
+    return mRealtime;
+}
+
+void Scheduler::setDeadline(double iDeadline)
+{
+    if (iDeadline > 0)
+        mDeadline = iDeadline;
+}
+
+double Scheduler::deadline() const
+{
+    return mDeadline;
+}
+
+void Scheduler::setCadence(Stage iStage, unsigned int iPeriod)
+{
+    mStages[iStage].period = std::max(1u, iPeriod);
+    stagger();
+}
+
+void Scheduler::setUrgent(Stage iStage, bool iUrgent)
+{
+    mStages[iStage].urgent = iUrgent;
+}
+
+
+//
+// Scheduling
+//
+
+// Start the frame clock, and plan which stages are due and expected to fit
+void Scheduler::beginFrame(unsigned long iFrame)
+{
+    mClock.start();
+
+    double tPlanned = 0;
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        StageState& tState = mStages[i];
+        tState.planned = tState.urgent || (iFrame % tState.period == tState.phase);
+        if (!tState.planned)
+            continue;
+        if (!mRealtime || tState.mandatory)
+        {
+            tPlanned += tState.cost;
+            continue;
+        }
+
+        if (tPlanned + tState.cost > mDeadline)
+            skip(tState);
+        else
+            tPlanned += tState.cost;
+    }
+}
+
+// Check whether a stage can still run. Stages which were planned get
+// rejected anyway when the stages before them took longer than expected.
+bool Scheduler::admit(Stage iStage)
+{
+    StageState& tState = mStages[iStage];
+    if (!tState.planned)
+        return false;
+    if (!mRealtime || tState.mandatory)
+        return true;
+
+    if (elapsed() + tState.cost > mDeadline)
+    {
+        skip(tState);
+        return false;
+    }
+    return true;
+}
+
+// Register the cost of a stage which ran, and adapt its level of detail
+void Scheduler::finished(Stage iStage, double iCost)
+{
+    StageState& tState = mStages[iStage];
+    if (tState.cost == 0)
+        tState.cost = iCost;
+    else
+        tState.cost = (1 - COST_SMOOTHING) * tState.cost + COST_SMOOTHING * iCost;
+
+    if (!mRealtime)
+        return;
+    double tBudget = tState.budget * mDeadline;
+    if (tState.cost > tBudget)
+        tState.detail = std::max(DETAIL_MIN, tState.detail * DETAIL_STEP);
+    else if (tState.cost < DETAIL_RECOVER * tBudget)
+        tState.detail = std::min(1.0, tState.detail / DETAIL_STEP);
+}
+
+double Scheduler::elapsed() const
+{
+    return mClock.elapsed();
+}
+
+double Scheduler::detail(Stage iStage) const
+{
+    if (!mRealtime)
+        return 1;
+    return mStages[iStage].detail;
+}
+
+
+//
+// Statistics
+//
+
+unsigned long Scheduler::skipped(Stage iStage) const
+{
+    return mStages[iStage].skipped;
+}
+
+
+//
+// Auxiliary
+//
+
+// Assign phases in order of priority. Two stages with periods P and Q and
+// phases p and q collide on some frame iff p and q are congruent modulo
+// gcd(P, Q), so pick the first phase which doesn't collide with any of the
+// stages before it (or with the fewest of them, if that's impossible).
+void Scheduler::stagger()
+{
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        StageState& tState = mStages[i];
+        if (tState.period == 1)
+        {
+            tState.phase = 0;
+            continue;
+        }
+
+        int tBestCollisions = STAGE_COUNT;
+        for (unsigned int tPhase = 0; tPhase < tState.period; tPhase++)
+        {
+            int tCollisions = 0;
+            for (int j = 0; j < i; j++)
+            {
+                const StageState& tOther = mStages[j];
+                if (tOther.period == 1)
+                    continue;
+                unsigned int a = tState.period, b = tOther.period;
+                while (b != 0)
+                {
+                    unsigned int t = a % b;
+                    a = b;
+                    b = t;
+                }
+                if (tPhase % a == tOther.phase % a)
+                    tCollisions++;
+            }
+            if (tCollisions < tBestCollisions)
+            {
+                tBestCollisions = tCollisions;
+                tState.phase = tPhase;
+            }
+        }
+    }
+}
+
+// Skipped stages don't get their cost measured, so let the estimate decay in
+// order for them to be retried eventually
+void Scheduler::skip(StageState& iState)
+{
+    iState.planned = false;
+    iState.skipped++;
+    iState.cost *= COST_DECAY;
+}
@@ -0,0 +1,84 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// Includes
+#include <QTime>
+
+// Enumerations
+enum Stage {
+    STAGE_TRACK = 0,
+    STAGE_TRAM,
+    STAGE_DISTANCE,
+    STAGE_PEDESTRIAN,
+    STAGE_VEHICLE,
+    STAGE_COUNT
+};
+
+/*
+  The Scheduler decides which components get to run on a frame. Outside of
+  real-time mode every component which is due runs. In real-time mode every frame
+  has a deadline, and each stage has a budget (a share of that deadline) and
+  a running cost estimate. Mandatory stages always run; the others, in order
+  of priority, only run as long as they are expected to finish before the
+  deadline. Stages which keep overrunning their budget are asked to work at
+  a lower level of detail, and recover once they fit again.
+
+  Independently of the deadline, every stage has a cadence: it only runs
+  every so many processed frames. The phases of the stages are staggered, so that
+  (where the periods allow it) the heavy stages never run on the same frame.
+  Stages marked urgent (because of a hazard they need to keep an eye on) are
+  due on every frame.
+  */
+class Scheduler
+{
+public:
+    // Construction and destruction
+    Scheduler();
+
+    // Configuration
+    void setRealtime(bool iRealtime);
+    bool realtime() const;
+    void setDeadline(double iDeadline);
+    double deadline() const;
+    void setCadence(Stage iStage, unsigned int iPeriod);
+    void setUrgent(Stage iStage, bool iUrgent);
+
+    // Scheduling
+    void beginFrame(unsigned long iFrame);
+    bool admit(Stage iStage);
+    void finished(Stage iStage, double iCost);
+    double elapsed() const;
+    double detail(Stage iStage) const;
+
+    // Statistics
+    unsigned long skipped(Stage iStage) const;
+
+private:
+    // Stage bookkeeping
+    struct StageState
+    {
+        bool mandatory;
+        double budget;      // fraction of the deadline
+        double cost;        // running estimate, in milliseconds
+        double detail;      // working resolution factor
+        unsigned int period, phase;
+        bool urgent;
+        bool planned;
+        unsigned long skipped;
+    };
+    void skip(StageState& iState);
+    void stagger();
+
+    // Member data
+    bool mRealtime;
+    double mDeadline;
+    QTime mClock;
+    StageState mStages[STAGE_COUNT];
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,143 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef SEGMENTSET_H
+#define SEGMENTSET_H
+
+// Includes
+#include "opencv/cv.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "auxiliary.h"
+
+/*
+  A SegmentSet stores line segments as a structure of arrays: the start
+  and end coordinates of all segments are kept in contiguous arrays, so a
+  pass over every segment streams through memory instead of chasing a
+  pointer per segment, and lends itself to vectorisation.
+
+  Every segment also gets its derived attributes calculated once when it
+  is added (its orientation, direction, horizontal midpoint and vertical
+  extent), so the later stages read them instead of each recomputing the
+  trigonometry for every pair of segments they compare.
+
+  Containers get exchanged with swap() rather than copied.
+  */
+struct SegmentSet
+{
+    size_t size() const
+    {
+        return x1.size();
+    }
+
+    void clear()
+    {
+        x1.clear();
+        y1.clear();
+        x2.clear();
+        y2.clear();
+        angle.clear();
+        dx.clear();
+        dy.clear();
+        mx.clear();
+        ymin.clear();
+        ymax.clear();
+    }
+
+    void reserve(size_t iSize)
+    {
+        x1.reserve(iSize);
+        y1.reserve(iSize);
+        x2.reserve(iSize);
+        y2.reserve(iSize);
+        angle.reserve(iSize);
+        dx.reserve(iSize);
+        dy.reserve(iSize);
+        mx.reserve(iSize);
+        ymin.reserve(iSize);
+        ymax.reserve(iSize);
+    }
+
+    void push_back(const cv::Point& iA, const cv::Point& iB)
+    {
+        x1.push_back(iA.x);
+        y1.push_back(iA.y);
+        x2.push_back(iB.x);
+        y2.push_back(iB.y);
+
+        // Derived attributes
+        float tDx = iB.x - iA.x, tDy = iB.y - iA.y;
+        angle.push_back(atan2(-tDy, -tDx));
+        dx.push_back(tDx);
+        dy.push_back(tDy);
+        mx.push_back((iA.x + iB.x) / 2.0f);
+        ymin.push_back(std::min(iA.y, iB.y));
+        ymax.push_back(std::max(iA.y, iB.y));
+    }
+
+    // Orientation of the segment without its direction, in [0, pi]
+    float slope(size_t i) const
+    {
+        return fabs(angle[i]);
+    }
+
+    // Orientation of the segment pointing from its lowest point (in image
+    // coordinates) to its highest one, in [-pi, 0]
+    float slopeUpwards(size_t i) const
+    {
+        return (y1[i] > y2[i]) ? angle[i] - (float) M_PI : angle[i];
+    }
+
+    Line line(size_t i) const
+    {
+        return Line(cv::Point(cvRound(x1[i]), cvRound(y1[i])), cv::Point(cvRound(x2[i]), cvRound(y2[i])));
+    }
+
+    void swap(SegmentSet& iOther)
+    {
+        x1.swap(iOther.x1);
+        y1.swap(iOther.y1);
+        x2.swap(iOther.x2);
+        y2.swap(iOther.y2);
+        angle.swap(iOther.angle);
+        dx.swap(iOther.dx);
+        dy.swap(iOther.dy);
+        mx.swap(iOther.mx);
+        ymin.swap(iOther.ymin);
+        ymax.swap(iOther.ymax);
+    }
+
+    // End points
+    std::vector<float> x1, y1, x2, y2;
+
+    // Derived attributes
+    std::vector<float> angle;           // of the second point towards the first one
+    std::vector<float> dx, dy;          // of the first point towards the second one
+    std::vector<float> mx;              // horizontal midpoint
+    std::vector<float> ymin, ymax;      // vertical extent
+};
+
+/*
+  A partition of a SegmentSet into groups, stored as index spans: the
+  members of group g are members[offsets[g]] up to (but not including)
+  members[offsets[g+1]].
+  */
+struct SegmentGroups
+{
+    size_t size() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    size_t count(size_t g) const
+    {
+        return offsets[g+1] - offsets[g];
+    }
+
+    std::vector<int> members, offsets;
+};
+
+#endif // SEGMENTSET_H
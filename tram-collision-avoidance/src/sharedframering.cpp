@@ -0,0 +1,247 @@
+//
+// Configuration
+//
+
+// Includes
+#include "sharedframering.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <QMutexLocker>
+#include "logger.h"
+
+
+//
+// Construction and destruction
+//
+
+// Map the ring with the given name (as passed to shm_open), once its
+// producer has set it up
+SharedFrameRing* SharedFrameRing::open(const std::string& iName)
+{
+    int tFile = shm_open(iName.c_str(), O_RDWR, 0);
+    if (tFile < 0)
+    {
+        Logger::instance().log(LOG_ERROR, LOG_CAPTURE, "could not open shared frames {}: {}", iName, std::string(strerror(errno)));
+        return 0;
+    }
+    struct stat tStat;
+    void* tMemory = MAP_FAILED;
+    if (fstat(tFile, &tStat) == 0 && (size_t) tStat.st_size >= sizeof(SharedFramesHeader))
+        tMemory = mmap(0, tStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, tFile, 0);
+    ::close(tFile);
+    if (tMemory == MAP_FAILED)
+    {
+        Logger::instance().log(LOG_ERROR, LOG_CAPTURE, "could not map shared frames {}", iName);
+        return 0;
+    }
+
+    // Don't trust the producer with the layout of the memory
+    SharedFramesHeader* tHeader = (SharedFramesHeader*) tMemory;
+    size_t tSize = tStat.st_size;
+    if (tHeader->magic != SHARED_FRAMES_MAGIC || tHeader->version != SHARED_FRAMES_VERSION
+        || tHeader->slots < 3 || tHeader->slots > SHARED_FRAMES_MAX_SLOTS
+        || tHeader->width == 0 || tHeader->height == 0
+        || tHeader->step < tHeader->width * CV_ELEM_SIZE(tHeader->type)
+        || (uint64_t) tHeader->step * tHeader->height > tHeader->slotSize
+        || tHeader->dataOffset < sizeof(SharedFramesHeader)
+        || tHeader->dataOffset + tHeader->slots * tHeader->slotSize > tSize)
+    {
+        Logger::instance().log(LOG_ERROR, LOG_CAPTURE, "shared frames {} have an unknown layout", iName);
+        munmap(tMemory, tSize);
+        return 0;
+    }
+
+    // Holds left behind by a previous consumer would keep those slots
+    // from ever being filled again
+    for (uint32_t i = 0; i < tHeader->slots; i++)
+        __sync_lock_test_and_set(&tHeader->slot[i].held, 0);
+    return new SharedFrameRing(tHeader, tSize);
+}
+
+// Let go of the ring, which only gets unmapped (and destroyed) once no
+// frame wraps any of its slots anymore
+void SharedFrameRing::close()
+{
+    bool tDelete;
+    {
+        QMutexLocker tLocker(&mMutex);
+        mClosed = true;
+        tDelete = mFrames == 0;
+    }
+    if (tDelete)
+        delete this;
+}
+
+SharedFrameRing::SharedFrameRing(SharedFramesHeader* iHeader, size_t iSize)
+    : mHeader(iHeader), mSize(iSize), mPending(-1), mFrames(0), mClosed(false), mFetched(false), mSequence(0), mDropped(0)
+{
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    munmap(mHeader, mSize);
+}
+
+
+//
+// Frames
+//
+
+// Wrap the newest frame, if it hasn't been fetched before. Its slot stays
+// held until the returned matrix (and every copy of it) gets released.
+bool SharedFrameRing::latest(cv::Mat& oFrame, uint64_t& oSequence, double& oPosition, uint64_t& oWritten)
+{
+    // A previous frame being let go of here would release its slot, which
+    // takes the lock as well
+    oFrame.release();
+
+    QMutexLocker tLocker(&mMutex);
+    if (__sync_fetch_and_add(&mHeader->published, 0) == 0)
+        return false;
+
+    // Pin the latest slot, and make sure it still is the latest one once
+    // pinned (otherwise the producer may have picked it to fill next)
+    uint32_t tSlot;
+    for (;;)
+    {
+        tSlot = __sync_fetch_and_add(&mHeader->latest, 0);
+        if (tSlot >= mHeader->slots)
+            return false;
+        __sync_fetch_and_add(&mHeader->slot[tSlot].held, 1);
+        if (__sync_fetch_and_add(&mHeader->latest, 0) == tSlot)
+            break;
+        __sync_fetch_and_sub(&mHeader->slot[tSlot].held, 1);
+    }
+
+    const SharedFrameSlot& tInfo = mHeader->slot[tSlot];
+    if (mFetched && tInfo.sequence == mSequence)
+    {
+        __sync_fetch_and_sub(&mHeader->slot[tSlot].held, 1);
+        return false;
+    }
+    if (mFetched && tInfo.sequence > mSequence + 1)
+        mDropped += tInfo.sequence - mSequence - 1;
+    mFetched = true;
+    mSequence = tInfo.sequence;
+    oSequence = tInfo.sequence;
+    oPosition = tInfo.position;
+    oWritten = tInfo.written;
+
+    // The pin becomes the hold of the matrix
+    cv::Mat tFrame;
+    tFrame.allocator = this;
+    mPending = tSlot;
+    tFrame.create(mHeader->height, mHeader->width, mHeader->type);
+    mPending = -1;
+    oFrame = tFrame;
+    return true;
+}
+
+// Whether the producer is done, and its last frame has been fetched
+bool SharedFrameRing::finished()
+{
+    QMutexLocker tLocker(&mMutex);
+    if (__sync_fetch_and_add(&mHeader->closed, 0) == 0)
+        return false;
+    if (__sync_fetch_and_add(&mHeader->published, 0) == 0)
+        return true;
+    uint32_t tSlot = __sync_fetch_and_add(&mHeader->latest, 0);
+    return tSlot >= mHeader->slots || (mFetched && mHeader->slot[tSlot].sequence == mSequence);
+}
+
+
+//
+// Properties
+//
+
+double SharedFrameRing::fps() const
+{
+    return mHeader->fps;
+}
+
+cv::Size SharedFrameRing::size() const
+{
+    return cv::Size(mHeader->width, mHeader->height);
+}
+
+
+//
+// Statistics
+//
+
+// Frames which got replaced by a newer one before being fetched (or which
+// the producer had no room for)
+unsigned long SharedFrameRing::dropped()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mDropped;
+}
+
+
+//
+// Matrix allocator interface
+//
+
+void SharedFrameRing::allocate(int iDims, const int* iSizes, int iType, int*& oRefcount, uchar*& oDatastart, uchar*& oData, size_t* oStep)
+{
+    // Wrap the slot being fetched
+    if (mPending >= 0 && iDims == 2)
+    {
+        oStep[1] = CV_ELEM_SIZE(iType);
+        oStep[0] = mHeader->step;
+        oDatastart = oData = data(mPending);
+        oRefcount = new int(1);
+        mFrames++;
+        return;
+    }
+
+    // A matrix which once wrapped a slot keeps this allocator, so anything
+    // else it gets recreated as comes from the heap, like the default
+    // allocator would do it
+    size_t tTotal = CV_ELEM_SIZE(iType);
+    for (int i = iDims - 1; i >= 0; i--)
+    {
+        oStep[i] = tTotal;
+        tTotal *= iSizes[i];
+    }
+    size_t tSize = cv::alignSize(tTotal, (int) sizeof(*oRefcount));
+    oDatastart = oData = (uchar*) cv::fastMalloc(tSize + sizeof(*oRefcount));
+    oRefcount = (int*) (oDatastart + tSize);
+    *oRefcount = 1;
+}
+
+void SharedFrameRing::deallocate(int* iRefcount, uchar* iDatastart, uchar*)
+{
+    if (iDatastart < data(0) || iDatastart >= (uchar*) mHeader + mSize)
+    {
+        cv::fastFree(iDatastart);
+        return;
+    }
+
+    int tSlot = (iDatastart - data(0)) / mHeader->slotSize;
+    __sync_fetch_and_sub(&mHeader->slot[tSlot].held, 1);
+    delete iRefcount;
+
+    bool tDelete;
+    {
+        QMutexLocker tLocker(&mMutex);
+        mFrames--;
+        tDelete = mClosed && mFrames == 0;
+    }
+    if (tDelete)
+        delete this;
+}
+
+
+//
+// Auxiliary
+//
+
+uchar* SharedFrameRing::data(int iSlot) const
+{
+    return (uchar*) mHeader + mHeader->dataOffset + iSlot * mHeader->slotSize;
+}
@@ -0,0 +1,70 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+// Includes
+#include "opencv/cv.h"
+#include <string>
+#include <QMutex>
+#include "sharedframes.h"
+
+/*
+  The SharedFrameRing reads the frames an external decoder writes into a
+  ring in POSIX shared memory (see sharedframes.h), so a stream which gets
+  decoded for another purpose on the same machine doesn't get decoded twice.
+
+  Frames don't get copied: a fetched frame is a matrix wrapping its slot,
+  which acts as its allocator. The slot stays held, so the producer leaves
+  it alone, for as long as any matrix refers to it, and gets released when
+  the last one does. For the same reason a ring only gets created on the
+  heap, and closing it only unmaps the memory once the last frame is gone.
+  */
+class SharedFrameRing : public cv::MatAllocator
+{
+public:
+    // Construction and destruction
+    static SharedFrameRing* open(const std::string& iName);
+    void close();
+
+    // Frames
+    bool latest(cv::Mat& oFrame, uint64_t& oSequence, double& oPosition, uint64_t& oWritten);
+    bool finished();
+
+    // Properties
+    double fps() const;
+    cv::Size size() const;
+
+    // Statistics
+    unsigned long dropped();
+
+    // Matrix allocator interface
+    void allocate(int iDims, const int* iSizes, int iType, int*& oRefcount, uchar*& oDatastart, uchar*& oData, size_t* oStep);
+    void deallocate(int* iRefcount, uchar* iDatastart, uchar* iData);
+
+private:
+    // Construction and destruction
+    SharedFrameRing(SharedFramesHeader* iHeader, size_t iSize);
+    ~SharedFrameRing();
+
+    // Auxiliary
+    uchar* data(int iSlot) const;
+
+    // Member data
+    SharedFramesHeader* mHeader;
+    size_t mSize;
+    QMutex mMutex;
+    int mPending, mFrames;
+    bool mClosed, mFetched;
+    uint64_t mSequence;
+    unsigned long mDropped;
+
+    // Disable copying
+    SharedFrameRing(const SharedFrameRing&);
+    SharedFrameRing& operator=(const SharedFrameRing&);
+};
+
+#endif // SHAREDFRAMERING_H
@@ -0,0 +1,69 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef SHAREDFRAMES_H
+#define SHAREDFRAMES_H
+
+// Includes
+#include <stdint.h>
+
+// Ring properties
+#define SHARED_FRAMES_MAGIC 0x4d524653     // "SFRM" in memory, on a little endian host
+#define SHARED_FRAMES_VERSION 1
+#define SHARED_FRAMES_MAX_SLOTS 8
+#define SHARED_FRAMES_ALIGN 4096            // of the slots, in bytes
+
+/*
+  The layout of a ring of decoded frames in POSIX shared memory, written by
+  an external decoder (the producer) and read by a single consuming process.
+  The memory object starts with this header, followed by the slots at
+  dataOffset, slotSize bytes apart, each holding one frame of the given
+  size, OpenCV type and row step.
+
+  The producer fills a slot, and only then makes it the latest one. It
+  never fills the latest slot, nor one the consumer holds; it picks the
+  slot to fill next right after publishing, like the FeaturePublisher does.
+  The consumer pins the latest slot by raising its hold count, and keeps it
+  only if it still is the latest one once pinned. When every other slot is
+  held, the producer skips frames rather than waiting.
+
+  All fields shared while running are accessed with full barriers (the
+  __sync builtins). This header doesn't depend on anything but the C
+  library, so a producer can include it on its own.
+  */
+
+struct SharedFrameSlot
+{
+    uint64_t sequence;          // frames the producer wrote before this one
+    double position;            // since the start of the source, in milliseconds
+    uint64_t written;           // on the monotonic clock, in microseconds
+    uint32_t held;              // frames of the consumer wrapping this slot
+    uint32_t reserved;
+};
+
+struct SharedFramesHeader
+{
+    // Set up by the producer before anything gets published
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t width, height;
+    uint32_t type;              // as the OpenCV matrix type, e.g. CV_8UC3
+    uint32_t step;              // between rows, in bytes
+    uint32_t reserved;
+    uint64_t slotSize;          // between slots, a multiple of SHARED_FRAMES_ALIGN
+    uint64_t dataOffset;        // of the first slot, a multiple of SHARED_FRAMES_ALIGN
+    double fps;
+
+    // Shared while running
+    uint32_t latest;            // slot of the newest complete frame
+    uint32_t published;         // whether latest is valid yet
+    uint32_t closed;            // whether the producer is done
+    uint32_t skipped;           // frames the producer had no free slot for
+
+    SharedFrameSlot slot[SHARED_FRAMES_MAX_SLOTS];
+};
+
+#endif // SHAREDFRAMES_H
@@ -0,0 +1,182 @@
+//
+// Configuration
+//
+
+// Includes
+#include "streamserver.h"
+#include "logger.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+
+// Server properties
+#define SERVER_REPORT_INTERVAL 5000     // in milliseconds
+
+
+//
+// Construction and destruction
+//
+
+StreamServer::StreamServer(int iThreads) : mPool(iThreads)
+{
+    mQueuedMetric = Metrics::instance().gauge("tram_pool_queued_tasks", "Streams waiting for a worker thread.");
+}
+
+StreamServer::~StreamServer()
+{
+    mPool.stop();
+    for (size_t i = 0; i < mStreams.size(); i++)
+        delete mStreams[i];
+}
+
+
+//
+// Streams
+//
+
+// Open a stream (a video file, a device or a stream URL)
+bool StreamServer::add(const QString& iSource, int iPriority)
+{
+    Stream* tStream = new Stream(iSource, iPriority, mStreams.size(), &mResources);
+    if (!tStream->open())
+    {
+        Logger::instance().log(LOG_ERROR, LOG_SERVER, "could not open {}", iSource.toStdString());
+        delete tStream;
+        return false;
+    }
+    mStreams.push_back(tStream);
+    mReported.push_back(0);
+    mFpsMetrics.push_back(Metrics::instance().gauge("tram_stream_fps", "Frames processed per second, over the last report interval.",
+                                                    Metrics::label("stream", iSource.toStdString())));
+    return true;
+}
+
+// Process all streams until they end, reporting on them periodically
+int StreamServer::exec()
+{
+    if (mStreams.empty())
+        return 1;
+
+    Logger::instance().log(LOG_INFO, LOG_SERVER, "processing {} stream(s) on {} thread(s)", mStreams.size(), mPool.threads());
+    for (size_t i = 0; i < mStreams.size(); i++)
+        mPool.submit(mStreams[i]);
+
+    QElapsedTimer tClock;
+    tClock.start();
+    while (!mPool.wait(SERVER_REPORT_INTERVAL))
+        report(tClock.restart() / 1000.0);
+    report(tClock.restart() / 1000.0);
+    return 0;
+}
+
+
+//
+// Auxiliary
+//
+
+void StreamServer::report(double iInterval)
+{
+    for (size_t i = 0; i < mStreams.size(); i++)
+    {
+        unsigned long tFrames, tDropped;
+        qint64 tLatency, tLatencyTotal;
+        mStreams[i]->statistics(tFrames, tLatency, tLatencyTotal, tDropped);
+        double tFps = iInterval > 0 ? (tFrames - mReported[i]) / iInterval : 0;
+        mReported[i] = tFrames;
+        mFpsMetrics[i]->set(tFps);
+
+        Logger::instance().log(LOG_INFO, LOG_SERVER, "[{}] {}: {.1} fps, latency {} ms ({} ms average), {} frames, {} dropped",
+                               i, mStreams[i]->source().toStdString(), tFps, tLatency, (tFrames > 0 ? tLatencyTotal / tFrames : 0), tFrames, tDropped);
+    }
+    Logger::instance().log(LOG_INFO, LOG_SERVER, "{} tasks stolen between threads", mPool.stolen());
+    mQueuedMetric->set(mPool.queued());
+}
+
+
+//
+// Stream
+//
+
+StreamServer::Stream::Stream(const QString& iSource, int iPriority, unsigned int iIndex, const Resources* iResources)
+    : WorkPool::Task(iPriority), mSource(iSource), mLive(false), mFramePosition(0), mPipeline(iResources, iSource.toStdString(), iIndex), mFrames(0), mLatency(0), mLatencyTotal(0)
+{
+}
+
+// Files get read in order, everything else is captured live
+bool StreamServer::Stream::open()
+{
+    mLive = !QFileInfo(mSource).isFile();
+    double tFps;
+    if (mLive)
+    {
+        if (!mGrabber.open(mSource.toStdString()))
+            return false;
+        tFps = mGrabber.fps();
+    }
+    else
+    {
+        if (!mCapture.open(mSource.toStdString()))
+            return false;
+        tFps = mCapture.get(CV_CAP_PROP_FPS);
+    }
+
+    // Live streams need to keep up, files can take all the time they need
+    mPipeline.reset(tFps);
+    mPipeline.scheduler().setRealtime(mLive);
+    mClock.start();
+    return true;
+}
+
+// Process the next frame, and ask to run again unless the stream ended (or
+// to be run a bit later, if a live stream has no new frame yet)
+WorkPool::Task::Result StreamServer::Stream::run()
+{
+    cv::Mat tFrame;
+    unsigned long tFrameNumber;
+    double tTimestamp;
+    qint64 tAvailable;
+    if (mLive)
+    {
+        FrameGrabber::Stamp tStamp;
+        if (!mGrabber.latest(tFrame, tStamp))
+            return mGrabber.finished() ? DONE : LATER;
+        tFrameNumber = tStamp.sequence;
+        tTimestamp = tStamp.position;
+        tAvailable = tStamp.captured;
+    }
+    else
+    {
+        tAvailable = mClock.elapsed();
+        mCapture >> tFrame;
+        if (!tFrame.data)
+            return DONE;
+        tFrameNumber = mFramePosition++;
+        tTimestamp = mCapture.get(CV_CAP_PROP_POS_MSEC);
+    }
+
+    cv::Mat tDebug;
+    mPipeline.process(tFrame, tFrameNumber, tTimestamp, VIEW_NONE, tDebug);
+    qint64 tLatency = (mLive ? mGrabber.elapsed() : mClock.elapsed()) - tAvailable;
+    mPipeline.reportCapture(tLatency, mLive ? mGrabber.dropped() : 0);
+
+    QMutexLocker tLocker(&mMutex);
+    mFrames++;
+    mLatency = tLatency;
+    mLatencyTotal += tLatency;
+    return AGAIN;
+}
+
+QString StreamServer::Stream::source() const
+{
+    return mSource;
+}
+
+// Frames processed, the latency of the last one and the sum of all of them
+// (in milliseconds), and the live frames which got dropped
+void StreamServer::Stream::statistics(unsigned long& oFrames, qint64& oLatency, qint64& oLatencyTotal, unsigned long& oDropped)
+{
+    QMutexLocker tLocker(&mMutex);
+    oFrames = mFrames;
+    oLatency = mLatency;
+    oLatencyTotal = mLatencyTotal;
+    oDropped = mLive ? mGrabber.dropped() : 0;
+}
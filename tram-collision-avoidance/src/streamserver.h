@@ -0,0 +1,90 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef STREAMSERVER_H
+#define STREAMSERVER_H
+
+// Includes
+#include "opencv/cv.h"
+#include "highgui.h"
+#include <vector>
+#include <QString>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "resources.h"
+#include "pipeline.h"
+#include "framegrabber.h"
+#include "workpool.h"
+#include "metrics.h"
+
+/*
+  The StreamServer processes several streams in a single process, without
+  any interface. All streams share the detector resources and a pool of
+  worker threads; every stream has a pipeline of its own, and gets processed
+  one frame at a time, so the pool spreads the streams over the cores (and
+  streams with a higher priority get their frames processed first).
+
+  Video files get processed frame by frame, as fast as the pool allows,
+  while live sources always get their newest frame processed. The frame
+  rate and latency of every stream get reported periodically, both in the
+  log and through the metrics registry.
+  */
+class StreamServer
+{
+public:
+    // Construction and destruction
+    StreamServer(int iThreads);
+    ~StreamServer();
+
+    // Streams
+    bool add(const QString& iSource, int iPriority = 0);
+    int exec();
+
+private:
+    // A single stream, processed by the pool
+    class Stream : public WorkPool::Task
+    {
+    public:
+        Stream(const QString& iSource, int iPriority, unsigned int iIndex, const Resources* iResources);
+
+        // Processing
+        bool open();
+        Result run();
+
+        // Statistics
+        QString source() const;
+        void statistics(unsigned long& oFrames, qint64& oLatency, qint64& oLatencyTotal, unsigned long& oDropped);
+
+    private:
+        // Input
+        QString mSource;
+        bool mLive;
+        cv::VideoCapture mCapture;
+        FrameGrabber mGrabber;
+        QElapsedTimer mClock;
+        unsigned long mFramePosition;
+
+        // Processing
+        Pipeline mPipeline;
+
+        // Statistics
+        QMutex mMutex;
+        unsigned long mFrames;
+        qint64 mLatency, mLatencyTotal;
+    };
+
+    // Auxiliary
+    void report(double iInterval);
+
+    // Member data
+    Resources mResources;
+    WorkPool mPool;
+    std::vector<Stream*> mStreams;
+    std::vector<unsigned long> mReported;
+    std::vector<Metrics::Gauge*> mFpsMetrics;
+    Metrics::Gauge* mQueuedMetric;
+};
+
+#endif // STREAMSERVER_H
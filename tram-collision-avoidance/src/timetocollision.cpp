@@ -0,0 +1,112 @@
+//
+// Configuration
+//
+
+// Includes
+#include "timetocollision.h"
+#include <algorithm>
+
+// Feature properties
+#define TTC_ALPHA 0.4           // weight of a measured width or distance
+#define TTC_BETA 0.1            // weight of a measured rate
+#define TTC_MIN_RATE 0.01       // relative growth per second (so at most 100 s)
+#define TTC_MIN_SPEED 0.1       // in meters per second
+#define TTC_MAX_GAP 1.0         // in seconds, after which the filter restarts
+
+
+//
+// Construction and destruction
+//
+
+TimeToCollision::TimeToCollision(FrameContext* iContext) : Component(iContext)
+{
+}
+
+
+//
+// Component interface
+//
+
+void TimeToCollision::preprocess()
+{
+    debug().setBackground(*frame());
+}
+
+FeatureStatus TimeToCollision::find_features(FrameFeatures& iFrameFeatures)
+{
+    TramMotion& tMotion = iFrameFeatures.tramMotion;
+    if (iFrameFeatures.tram.width == 0)
+    {
+        tMotion = TramMotion();
+        iFrameFeatures.closingSpeed = 0;
+        iFrameFeatures.timeToCollision = 0;
+        return FeatureStatus(REASON_MISSING_INPUT, "No tram to follow");
+    }
+
+    // An undetected tram is kept around for a while, but carries no news
+    if (iFrameFeatures.tramAge.frame != iFrameFeatures.frame)
+        return FeatureStatus::found();
+
+    double tWidth = iFrameFeatures.tram.width;
+    double tDistance = iFrameFeatures.tramDistance;
+    double tDelta = (iFrameFeatures.timestamp - tMotion.timestamp) / 1000;
+    if (!tMotion.valid || tDelta > TTC_MAX_GAP)
+    {
+        tMotion = TramMotion();
+        tMotion.valid = true;
+        tMotion.timestamp = iFrameFeatures.timestamp;
+        tMotion.width = tWidth;
+        tMotion.distance = tDistance;
+        iFrameFeatures.closingSpeed = 0;
+        iFrameFeatures.timeToCollision = 0;
+        return FeatureStatus::found();
+    }
+
+    // Not every video reports its position
+    if (tDelta <= 0)
+        return FeatureStatus(REASON_MISSING_INPUT, "No timing information");
+    tMotion.timestamp = iFrameFeatures.timestamp;
+
+    // Filter the width of the tram
+    double tPredicted = tMotion.width + tMotion.widthRate * tDelta;
+    double tResidual = tWidth - tPredicted;
+    tMotion.width = tPredicted + TTC_ALPHA * tResidual;
+    tMotion.widthRate += TTC_BETA * tResidual / tDelta;
+
+    // Filter its distance, if known
+    if (tDistance > 0 && tMotion.distance > 0)
+    {
+        tPredicted = tMotion.distance + tMotion.distanceRate * tDelta;
+        tResidual = tDistance - tPredicted;
+        tMotion.distance = tPredicted + TTC_ALPHA * tResidual;
+        tMotion.distanceRate += TTC_BETA * tResidual / tDelta;
+    }
+    else
+    {
+        tMotion.distance = tDistance;
+        tMotion.distanceRate = 0;
+    }
+
+    // Prefer the scale change, which doesn't depend on the distance
+    // estimate being right
+    double tScaleRate = tMotion.widthRate / tMotion.width;
+    if (tScaleRate > TTC_MIN_RATE)
+    {
+        iFrameFeatures.timeToCollision = 1 / tScaleRate;
+        iFrameFeatures.closingSpeed = tMotion.distance * tScaleRate;
+    }
+    else if (-tMotion.distanceRate > TTC_MIN_SPEED)
+    {
+        iFrameFeatures.timeToCollision = tMotion.distance / -tMotion.distanceRate;
+        iFrameFeatures.closingSpeed = -tMotion.distanceRate;
+    }
+    else
+    {
+        iFrameFeatures.timeToCollision = 0;
+        iFrameFeatures.closingSpeed = std::max(0.0, -tMotion.distanceRate);
+    }
+
+    if (debug().enabled())
+        debug().rectangle(iFrameFeatures.tram.tl(), iFrameFeatures.tram.br(), cv::Scalar(0, 0, 255), 2);
+    return FeatureStatus::found();
+}
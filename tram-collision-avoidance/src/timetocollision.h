@@ -0,0 +1,34 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef TIMETOCOLLISION_H
+#define TIMETOCOLLISION_H
+
+// Includes
+#include "opencv/cv.h"
+#include "component.h"
+#include "framefeatures.h"
+
+/*
+  The TimeToCollision component estimates how fast we're closing in on the
+  tram ahead, and when we'd hit it. The primary cue is the scale change of the
+  matched tram: an object at distance Z growing at a relative rate s'/s is hit
+  after 1/(s'/s), whatever its real size. The distance history gives a second
+  estimate, which covers for a tram whose scale can't be measured. Both rates
+  are smoothed with an alpha-beta filter, whose state is carried from frame
+  to frame in the features.
+  */
+class TimeToCollision : public Component
+{
+public:
+    // Construction and destruction
+    TimeToCollision(FrameContext* iContext);
+
+    // Component interface
+    void preprocess();
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
+};
+
+#endif // TIMETOCOLLISION_H
@@ -5,9 +5,15 @@
 // Includes
 #include "trackdetection.h"
 #include <limits>
-#include <QDebug>
-
-// Feature properties
+#include <algorithm>
+#include <map>
+#include "framearena.h"
+
+// Feature properties (lengths in pixels of the reference resolution)
+#define TRACK_WORKING_HEIGHT REFERENCE_HEIGHT
+#define HOUGH_THRESHOLD 15
+#define HOUGH_LINE_LENGTH 40
+#define HOUGH_LINE_GAP 3
 #define GROUP_SLOPE_DELTA M_PI_4/8.0    // about 5 degrees
 #define GROUP_DISTANCE_DELTA 15         // in pixels
 #define GROUP_SIZE 2
@@ -19,14 +25,20 @@
 #define TRACK_START_LOWER 10
 #define TRACK_START_UPPER 50
 #define TRACK_START_DELTA 10
+#define VALIDITY_START_LEFT (300.0/REFERENCE_WIDTH)     // fraction of the frame width
+#define VALIDITY_START_RIGHT (700.0/REFERENCE_WIDTH)    // fraction of the frame width
 #define VALIDITY_TRACK_DELTA 30
+#define HOUGH_HORIZONTAL_DELTA M_PI/18  // lines this close to horizontal are never rails
+#define HOUGH_BAND_SLOPE_DELTA M_PI/36  // slack on the angles of the predicted rails
+#define HOUGH_BAND_THETA CV_PI/360
+#define MODEL_BAND_WIDTH 40             // search band around each predicted rail
 
 
 //
 // Construction and destruction
 //
 
-TrackDetection::TrackDetection(cv::Mat const* iFrame) : Component(iFrame)
+TrackDetection::TrackDetection(FrameContext* iContext, TrackModel* iModel, BandedHough* iHough) : Component(iContext, TRACK_WORKING_HEIGHT), mModel(iModel), mHough(iHough)
 {
 
 }
@@ -38,13 +50,9 @@ TrackDetection::TrackDetection(cv::Mat const* iFrame) : Component(iFrame)
 
 void TrackDetection::preprocess()
 {
-    // Convert to grayscale
-    cv::Mat tFrameGray(frame()->size(), CV_8U);
-    cvtColor(*frame(), tFrameGray, CV_RGB2GRAY);
-
     // Sobel transform
     cv::Mat tFrameSobel(frame()->size(), CV_16S);
-    Sobel(tFrameGray, tFrameSobel, CV_16S, 3, 0, 9);
+    Sobel(frameGray(), tFrameSobel, CV_16S, 3, 0, 9);
 
     // Convert to 32F
     cv::Mat tFrameSobelFloat(frame()->size(), CV_8U);
@@ -55,7 +63,7 @@ void TrackDetection::preprocess()
 
     // Blank out useless region
     rectangle(tFrameThresholded, cv::Rect(0, 0, frame()->size().width, frame()->size().height * 0.50), cv::Scalar::all(0), CV_FILLED);
-    QVector<cv::Point> tRectRight, tRectLeft;
+    std::vector<cv::Point> tRectRight, tRectLeft;
     tRectRight.push_back(cv::Point(frame()->size().width, frame()->size().height));
     tRectRight.push_back(cv::Point(frame()->size().width-frame()->size().width*0.25, frame()->size().height));
     tRectRight.push_back(cv::Point(frame()->size().width, 0));
@@ -65,292 +73,326 @@ void TrackDetection::preprocess()
     tRectLeft.push_back(cv::Point(0, 0));
     fillConvexPoly(tFrameThresholded, &tRectLeft[0], tRectLeft.size(), cv::Scalar::all(0));
 
+    // If we know where the rails should be, only look in a band around them
+    // (the banded Hough transform does that by itself)
+    if (mModel != 0)
+    {
+        mModel->predict();
+        if (mModel->valid() && mHough == 0)
+        {
+            cv::Mat tBand = cv::Mat::zeros(tFrameThresholded.size(), CV_8U);
+            std::pair<Track, Track> tRails = mModel->rails(frame()->rows);
+            int tThickness = std::max(1, (int) reference(2*MODEL_BAND_WIDTH));
+            for (size_t i = 0; i + 1 < tRails.first.size(); i++)
+            {
+                cv::line(tBand, tRails.first[i], tRails.first[i+1], cv::Scalar::all(255), tThickness);
+                cv::line(tBand, tRails.second[i], tRails.second[i+1], cv::Scalar::all(255), tThickness);
+            }
+            tFrameThresholded &= tBand;
+        }
+    }
+
     // Save final frame
     mFramePreprocessed = tFrameThresholded;
-    cvtColor(mFramePreprocessed, mFrameDebug, CV_GRAY2BGR);
+    debug().setBackground(mFramePreprocessed);
 }
 
-void TrackDetection::find_features(FrameFeatures& iFrameFeatures) throw(FeatureException)
+FeatureStatus TrackDetection::find_features(FrameFeatures& iFrameFeatures)
 {
     // Detect lines
-    QList<Line> tLines = find_lines();
+    SegmentSet tLines;
+    find_lines(tLines);
 
     // Classify the lines
-    QList<QList<Line> > tGroups = find_groups(tLines);
-    foreach (const QList<Line>& tGroup, tGroups)
-    {
-        int tRandom = mRng;
-        cv::Scalar tColour = CV_RGB(tRandom&255, (tRandom>>8)&255, (tRandom>>16)&255);
-        foreach (const Line& tLine, tGroup)
-        {
-            cv::line(mFrameDebug,
-                 tLine.first,
-                 tLine.second,
-                 tColour,
-                 3,
-                 8
-                 );
-        }
-    }
+    SegmentGroups tGroups;
+    find_groups(tLines, tGroups);
 
     // Generate representatives
-    QList<Line> tRepresentatives = find_representatives(tGroups);
-    foreach (const Line& tRepresentative, tRepresentatives)
-    {
-        cv::line(mFrameDebug,
-             tRepresentative.first,
-             tRepresentative.second,
-             cv::Scalar(0, 0, 255),
-             5,
-             8
-             );
-    }
+    SegmentSet tRepresentatives;
+    find_representatives(tLines, tGroups, tRepresentatives);
+
+    // Stitch representative lines
+    std::vector<Track> tStitches;
+    find_stitches(tRepresentatives, tStitches);
 
-    // Stitch representatdan zoive lines
-    QList<Track > tStitches = find_stitches(tRepresentatives);
-    foreach (const Track& tStitch, tStitches)
+    // Visualise intermediate results
+    if (debug().enabled())
     {
-        Track::const_iterator tIterator = tStitch.begin();
-        cv::Point tPrevious = *tIterator++;
-        while (tIterator != tStitch.end())
+        for (size_t g = 0; g < tGroups.size(); g++)
         {
-            cv::Point tPoint = *tIterator++;
-            cv::line(mFrameDebug,
-                 tPrevious,
-                 tPoint,
-                 cv::Scalar(0, 255, 255),
-                 5,
-                 8
-                 );
-            tPrevious = tPoint;
+            int tRandom = mRng;
+            cv::Scalar tColour = CV_RGB(tRandom&255, (tRandom>>8)&255, (tRandom>>16)&255);
+            for (int i = tGroups.offsets[g]; i < tGroups.offsets[g+1]; i++)
+            {
+                Line tLine = tLines.line(tGroups.members[i]);
+                debug().line(tLine.first, tLine.second, tColour, 3, 8);
+            }
+        }
+        for (size_t i = 0; i < tRepresentatives.size(); i++)
+        {
+            Line tRepresentative = tRepresentatives.line(i);
+            debug().line(tRepresentative.first, tRepresentative.second, cv::Scalar(0, 0, 255), 5, 8);
+        }
+        for (size_t i = 0; i < tStitches.size(); i++)
+        {
+            for (size_t j = 0; j + 1 < tStitches[i].size(); j++)
+                debug().line(tStitches[i][j], tStitches[i][j+1], cv::Scalar(0, 255, 255), 5, 8);
         }
     }
 
     // Find valid tracks
-    for (int tScanheight = TRACK_START_LOWER; tScanheight < TRACK_START_UPPER ; tScanheight += TRACK_START_DELTA)
+    for (int tScanheight = reference(TRACK_START_LOWER); tScanheight < reference(TRACK_START_UPPER); tScanheight += std::max(1, (int) reference(TRACK_START_DELTA)))
     {
         TrackStart tTrackStart;
-        QPair<Track, Track> tTramTrack;
+        std::pair<Track, Track> tTramTrack;
         if (find_trackstart(tStitches, tScanheight, tTrackStart, tTramTrack))
         {
-            cv::circle(mFrameDebug,
-                       tTrackStart.first,
-                       8,
-                       cv::Scalar(0, 255, 255),
-                       2);
-            cv::circle(mFrameDebug,
-                       tTrackStart.second,
-                       8,
-                       cv::Scalar(0, 255, 255),
-                       2);
+            debug().circle(tTrackStart.first, 8, cv::Scalar(0, 255, 255), 2);
+            debug().circle(tTrackStart.second, 8, cv::Scalar(0, 255, 255), 2);
 
             if (tTramTrack.first.back().x > tTramTrack.second.back().x)
-                swap(tTramTrack.first, tTramTrack.second);
+                tTramTrack.first.swap(tTramTrack.second);
+
+            std::pair<Track, Track> tOldTrack(toWorking(iFrameFeatures.tracks.first), toWorking(iFrameFeatures.tracks.second));
+            FeatureStatus tValidity = check_validity(tOldTrack, tTramTrack);
+            if (!tValidity.ok())
+            {
+                if (mModel != 0)
+                    mModel->miss();
+                return tValidity;
+            }
+
+            // Report the filtered rails rather than the raw detection
+            if (mModel != 0)
+            {
+                mModel->correct(tTramTrack, frame()->rows);
+                if (mModel->valid())
+                    tTramTrack = mModel->rails(frame()->rows);
+            }
 
-            check_validity(iFrameFeatures.tracks, tTramTrack);
-            iFrameFeatures.tracks = tTramTrack;
-            return;
+            iFrameFeatures.tracks.first = toInput(tTramTrack.first);
+            iFrameFeatures.tracks.second = toInput(tTramTrack.second);
+            return FeatureStatus::found();
         }
     }
-    throw FeatureException("Could not identify track start");
-}
-
-cv::Mat TrackDetection::frameDebug() const
-{
-    return mFrameDebug;
+    if (mModel != 0)
+        mModel->miss();
+    return FeatureStatus(REASON_NOT_FOUND, "Could not identify track start");
 }
 
-
 //
 // Feature detection
 //
 
 // Find lines in a frams
-QList<Line> TrackDetection::find_lines()
+void TrackDetection::find_lines(SegmentSet& oLines)
 {
     // Find the lines through Hough transform
     std::vector<cv::Vec4i> tLines;
-    cv::HoughLinesP(mFramePreprocessed, // Image
+    if (mHough != 0)
+    {
+        // Only look at the angles a rail can have, and if we know where the
+        // rails should be, only around them
+        mHough->clear();
+        if (mModel != 0 && mModel->valid())
+        {
+            std::pair<Track, Track> tRails = mModel->rails(frame()->rows);
+            mHough->addBand(tRails.first, reference(MODEL_BAND_WIDTH), HOUGH_BAND_SLOPE_DELTA, HOUGH_BAND_THETA);
+            mHough->addBand(tRails.second, reference(MODEL_BAND_WIDTH), HOUGH_BAND_SLOPE_DELTA, HOUGH_BAND_THETA);
+        }
+        else
+            mHough->addBand(cv::Rect(0, 0, mFramePreprocessed.cols, mFramePreprocessed.rows), CV_PI/2 + HOUGH_HORIZONTAL_DELTA, 3*CV_PI/2 - HOUGH_HORIZONTAL_DELTA, CV_PI/180);
+        mHough->detect(mFramePreprocessed,
+                std::max(1, (int) reference(HOUGH_THRESHOLD)),
+                reference(HOUGH_LINE_LENGTH),
+                reference(HOUGH_LINE_GAP),
+                tLines);
+    }
+    else
+        cv::HoughLinesP(mFramePreprocessed, // Image
                 tLines,                 // Lines
                 1,                      // Rho
                 CV_PI/180,              // Theta
-                15,                     // Threshold
-                40,                     // Minimum line length
-                3                       // Maximum line gap
+                std::max(1, (int) reference(HOUGH_THRESHOLD)),     // Threshold
+                reference(HOUGH_LINE_LENGTH),                       // Minimum line length
+                reference(HOUGH_LINE_GAP)                           // Maximum line gap
                 );
 
-    // Convert to a list of lines
-    QList<Line> oLines;
+    // Convert to a set of segments
+    oLines.clear();
+    oLines.reserve(tLines.size());
     for(size_t i = 0; i < tLines.size(); i++)
+        oLines.push_back(cv::Point(tLines[i][0], tLines[i][1]), cv::Point(tLines[i][2], tLines[i][3]));
+}
+
+// Root of the group of a line, compressing the path along the way
+static int find_root(ArenaVector<int>::type& iParent, int i)
+{
+    while (iParent[i] != i)
     {
-        cv::Point tPointA(tLines[i][0], tLines[i][1]);
-        cv::Point tPointB(tLines[i][2], tLines[i][3]);
-        oLines.push_back(Line(tPointA, tPointB));
+        iParent[i] = iParent[iParent[i]];
+        i = iParent[i];
     }
-
-    return oLines;
+    return i;
 }
 
-QList<QList<Line> > TrackDetection::find_groups(const QList<Line>& iLines)
+// Group lines which are (transitively) matching, which is what repeatedly
+// merging matching groups until none match converges to
+void TrackDetection::find_groups(const SegmentSet& iLines, SegmentGroups& oGroups)
 {
-    // Populate initial group
-    QList<QList<Line> > oGroups;
-    for (int i = 0; i < iLines.size(); i++)
+    // Union-find, every line starting out as a group of its own (all the
+    // bookkeeping lives in the frame arena)
+    int tLines = iLines.size();
+    ArenaVector<int>::type tParent(tLines);
+    for (int i = 0; i < tLines; i++)
+        tParent[i] = i;
+
+    // The distances from a line to all later ones get calculated in one
+    // batch, and only the pairs close enough get their slopes compared
+    ArenaVector<float>::type tDistances2(tLines);
+    float tDistanceDelta = reference(GROUP_DISTANCE_DELTA);
+    for (int i = 0; i + 1 < tLines; i++)
     {
-        QList<Line> tGroup;
-        tGroup.push_back(iLines[i]);
-        oGroups.push_back(tGroup);
+        distance2_segment2segments(iLines.line(i), &iLines.x1[i+1], &iLines.y1[i+1], &iLines.x2[i+1], &iLines.y2[i+1],
+                                   &iLines.dx[i+1], &iLines.dy[i+1], tLines - i - 1, &tDistances2[0]);
+        for (int j = i+1; j < tLines; j++)
+        {
+            if (tDistances2[j-i-1] >= tDistanceDelta * tDistanceDelta)
+                continue;
+            int tRootA = find_root(tParent, i), tRootB = find_root(tParent, j);
+            if (tRootA != tRootB && segments_parallel(iLines, i, j))
+                tParent[std::max(tRootA, tRootB)] = std::min(tRootA, tRootB);
+        }
     }
 
-    // Classify
-    bool tFlux = true;
-    while (tFlux)
+    // Lay out the groups as spans, in order of their first line
+    ArenaVector<int>::type tGroup(tLines, -1);
+    oGroups.offsets.clear();
+    oGroups.offsets.push_back(0);
+    for (int i = 0; i < tLines; i++)
     {
-        tFlux = false;
-        QList<QList<Line> > tGroupsNew;
-
-        // Process each old group
-        while (oGroups.size() > 0)
+        int tRoot = find_root(tParent, i);
+        if (tGroup[tRoot] < 0)
         {
-            QList<Line> tGroup = oGroups.back();
-            oGroups.pop_back();
-
-            // Check if it fits in another existing group
-            if (tGroupsNew.size() > 0)
-            {
-                bool tFits = false;
-                for (int i = 0; i < tGroupsNew.size(); i++)
-                {
-                    if (groups_match(tGroup, tGroupsNew[i]))
-                    {
-                        foreach (Line tLine, tGroup)
-                            tGroupsNew[i].push_back(tLine);
-                        tFits = true;
-                        break;
-                    }
-                }
-
-                // Doesn't fit, just add it
-                if (! tFits)
-                    tGroupsNew.push_back(tGroup);
-                else
-                    tFlux = true;
-            }
-
-            // The first group cannot be matched, just add it
-            else
-                tGroupsNew.push_back(tGroup);
+            tGroup[tRoot] = oGroups.offsets.size() - 1;
+            oGroups.offsets.push_back(0);
         }
-
-        oGroups = tGroupsNew;
+        oGroups.offsets[tGroup[tRoot] + 1]++;
     }
+    for (size_t g = 1; g < oGroups.offsets.size(); g++)
+        oGroups.offsets[g] += oGroups.offsets[g-1];
 
-    return oGroups;
+    ArenaVector<int>::type tFill(oGroups.offsets.begin(), oGroups.offsets.end() - 1);
+    oGroups.members.resize(tLines);
+    for (int i = 0; i < tLines; i++)
+        oGroups.members[tFill[tGroup[find_root(tParent, i)]]++] = i;
 }
 
-QList<Line> TrackDetection::find_representatives(const QList<QList<Line> >& iGroups)
+void TrackDetection::find_representatives(const SegmentSet& iLines, const SegmentGroups& iGroups, SegmentSet& oRepresentatives)
 {
-    QList<Line> oRepresentatives;
-    foreach (const QList<Line>& tGroup, iGroups)
+    oRepresentatives.clear();
+    for (size_t g = 0; g < iGroups.size(); g++)
     {
-        if (tGroup.size() >= GROUP_SIZE)
+        if (iGroups.count(g) >= GROUP_SIZE)
         {
-            int tVerticalLowest = std::numeric_limits<int>::max(), tVerticalHighest = 0;
+            float tVerticalLowest = std::numeric_limits<float>::max(), tVerticalHighest = 0;
             double tSlopeTotal = 0;
-            long tHorizontalTotal = 0;
-            foreach (const Line& tLine, tGroup)
+            double tHorizontalTotal = 0;
+            for (int i = iGroups.offsets[g]; i < iGroups.offsets[g+1]; i++)
             {
-                cv::Point tLineLow = tLine.first, tLineHigh = tLine.second;
-                if (tLineLow.y > tLineHigh.y)
-                    swap(tLineLow, tLineHigh);
-
-                if (tLineLow.y < tVerticalLowest)
-                    tVerticalLowest = tLineLow.y;
-                if (tLineHigh.y > tVerticalHighest)
-                    tVerticalHighest = tLineHigh.y;
-
-                int tHorizontalMidpoint = (tLine.first.x + tLine.second.x) / 2;
-                tHorizontalTotal += tHorizontalMidpoint;
-
-                double tSlope = atan2(tLineLow.y - tLineHigh.y, tLineLow.x - tLineHigh.x);
-                tSlopeTotal += tSlope;
+                int tLine = iGroups.members[i];
+                tVerticalLowest = std::min(tVerticalLowest, iLines.ymin[tLine]);
+                tVerticalHighest = std::max(tVerticalHighest, iLines.ymax[tLine]);
+                tHorizontalTotal += iLines.mx[tLine];
+                tSlopeTotal += iLines.slopeUpwards(tLine);
             }
 
-            double tSlopeAverage = tSlopeTotal / tGroup.size();
-            int tHorizontalAverage = tHorizontalTotal / tGroup.size();
+            double tSlopeAverage = tSlopeTotal / iGroups.count(g);
+            double tHorizontalAverage = tHorizontalTotal / iGroups.count(g);
             double tHorizontalLength = (tVerticalHighest - tVerticalLowest) / tan(tSlopeAverage);
 
             cv::Point tBottom(tHorizontalAverage - tHorizontalLength/2, tVerticalLowest);
             cv::Point tTop(tHorizontalAverage + tHorizontalLength/2, tVerticalHighest);
 
-            oRepresentatives.append(Line(tBottom, tTop));
+            oRepresentatives.push_back(tBottom, tTop);
         }
     }
+}
 
-    return oRepresentatives;
+// Slope of the segment between two points, without its direction
+static float segment_slope(const cv::Point& iA, const cv::Point& iB)
+{
+    return fabs(atan2(iA.y - iB.y, iA.x - iB.x));
 }
 
-QList<Track > TrackDetection::find_stitches(const QList<Line>& iRepresentatives)
+void TrackDetection::find_stitches(const SegmentSet& iRepresentatives, std::vector<Track>& oStitches)
 {
-    QList<Track > oStitches;
-    foreach (Line tRepresentative, iRepresentatives)
+    // Every stitch keeps the slopes of its first and last segment, which
+    // only change when it gets another stitch appended
+    oStitches.clear();
+    oStitches.reserve(iRepresentatives.size());
+    ArenaVector<std::pair<float, float> >::type tSlopes;
+    tSlopes.reserve(iRepresentatives.size());
+    for (size_t i = 0; i < iRepresentatives.size(); i++)
     {
-        Track tInitialStitch;
-        tInitialStitch.append(tRepresentative.first);
-        tInitialStitch.append(tRepresentative.second);
-        oStitches.append(tInitialStitch);
+        Line tRepresentative = iRepresentatives.line(i);
+        oStitches.push_back(Track());
+        oStitches.back().push_back(tRepresentative.first);
+        oStitches.back().push_back(tRepresentative.second);
+        tSlopes.push_back(std::make_pair(iRepresentatives.slope(i), iRepresentatives.slope(i)));
     }
 
     bool tFlux = true;
     while (tFlux)
     {
         tFlux = false;
-        QList<Track > tStitchesNew;
+        std::vector<Track> tStitchesNew;
+        tStitchesNew.reserve(oStitches.size());
+        ArenaVector<std::pair<float, float> >::type tSlopesNew;
+        tSlopesNew.reserve(tSlopes.size());
 
         while (oStitches.size() > 0)
         {
-            Track tStitch = oStitches.back();
+            Track tStitch;
+            tStitch.swap(oStitches.back());
             oStitches.pop_back();
+            std::pair<float, float> tStitchSlopes = tSlopes.back();
+            tSlopes.pop_back();
 
             // Check if it fits in another existing group of stitches
-            if (tStitchesNew.size() > 0)
+            bool tFits = false;
+            for (size_t i = 0; i < tStitchesNew.size(); i++)
             {
-                bool tFits = false;
-                for (int i = 0; i < tStitchesNew.size(); i++)
+                cv::Point tStitchPoint;
+                if (stitches_match(tStitchesNew[i], tSlopesNew[i].second, tStitch, tStitchSlopes.first, tStitchPoint))
                 {
-                    cv::Point tStitchPoint;
-                    if (stitches_match(tStitchesNew[i], tStitch, tStitchPoint))
-                    {
-                        tStitchesNew[i].pop_back();
-                        tStitchesNew[i].append(tStitchPoint);
-                        tStitch.pop_front();
-                        foreach (cv::Point tPoint, tStitch)
-                            tStitchesNew[i].push_back(tPoint);
-                        tFits = true;
-                        break;
-                    }
+                    Track& tMerged = tStitchesNew[i];
+                    tMerged.back() = tStitchPoint;
+                    tMerged.insert(tMerged.end(), tStitch.begin() + 1, tStitch.end());
+                    tSlopesNew[i] = std::make_pair(segment_slope(tMerged[0], tMerged[1]), segment_slope(tMerged[tMerged.size()-2], tMerged.back()));
+                    tFits = true;
+                    break;
                 }
-
-                // Doesn't fit, just add it
-                if (! tFits)
-                    tStitchesNew.push_back(tStitch);
-                else
-                    tFlux = true;
             }
 
-            // The first stitch cannot be matched, just add it
+            // Doesn't fit (or it's the first one), just add it
+            if (! tFits)
+            {
+                tStitchesNew.push_back(Track());
+                tStitchesNew.back().swap(tStitch);
+                tSlopesNew.push_back(tStitchSlopes);
+            }
             else
-                tStitchesNew.push_back(tStitch);
+                tFlux = true;
         }
 
-        oStitches = tStitchesNew;
+        oStitches.swap(tStitchesNew);
+        tSlopes.swap(tSlopesNew);
     }
-
-    return oStitches;
 }
 
 
-bool TrackDetection::find_trackstart(const QList<Track >& iStitches, int iScanlineOffset, TrackStart& oTrackStart, QPair<Track, Track>& oTracks)
+bool TrackDetection::find_trackstart(const std::vector<Track>& iStitches, int iScanlineOffset, TrackStart& oTrackStart, std::pair<Track, Track>& oTracks)
 {
     int tScanlineHeight = mFramePreprocessed.size().height - iScanlineOffset;
     Line tScanline(
@@ -359,23 +401,21 @@ bool TrackDetection::find_trackstart(const QList<Track >& iStitches, int iScanli
                 );
 
     Track tScanlineIntersections;
-    QMap<int, Track> tTrackMap;
-    foreach (Track tStitch, iStitches)
+    std::map<int, size_t> tTrackMap;
+    for (size_t i = 0; i < iStitches.size(); i++)
     {
-        Track::const_iterator tIterator = tStitch.end();
-        Line tLowestSegment;
-        tLowestSegment.second = *--tIterator;
-        tLowestSegment.first = *--tIterator;
+        const Track& tStitch = iStitches[i];
+        Line tLowestSegment(tStitch[tStitch.size()-2], tStitch.back());
 
         cv::Point tTrackStart;
         if (intersect_segments(tScanline, tLowestSegment, tTrackStart))
         {
-            tScanlineIntersections.append(tTrackStart);
-            tTrackMap.insert(tTrackStart.x, tStitch);
+            tScanlineIntersections.push_back(tTrackStart);
+            tTrackMap[tTrackStart.x] = i;
         }
     }
 
-    QList<TrackStart> tTrackStarts;
+    std::vector<TrackStart> tTrackStarts;
     while (tScanlineIntersections.size() > 0)
     {
         cv::Point tPointA = tScanlineIntersections.back();
@@ -386,9 +426,9 @@ bool TrackDetection::find_trackstart(const QList<Track >& iStitches, int iScanli
         {
             cv::Point tPointB = *tIterator;
             double tDistance = abs(tPointA.x - tPointB.x);
-            if (tDistance > TRACK_SPACE_MIN && tDistance < TRACK_SPACE_MAX)
+            if (tDistance > reference(TRACK_SPACE_MIN) && tDistance < reference(TRACK_SPACE_MAX))
             {
-                tTrackStarts.append(TrackStart(tPointA, tPointB));
+                tTrackStarts.push_back(TrackStart(tPointA, tPointB));
                 tScanlineIntersections.erase(tIterator);
                 break;
             }
@@ -399,14 +439,15 @@ bool TrackDetection::find_trackstart(const QList<Track >& iStitches, int iScanli
     if (tTrackStarts.size() > 0)
     {
         int tBestTrackStartPosition = std::numeric_limits<int>::max();
-        foreach (TrackStart tTrackStart, tTrackStarts)
+        for (size_t i = 0; i < tTrackStarts.size(); i++)
         {
-            int tTrackStartPosition = (tTrackStart.first.x + tTrackStart.second.x)/2 - mFrameDebug.size().width/2;
+            const TrackStart& tTrackStart = tTrackStarts[i];
+            int tTrackStartPosition = (tTrackStart.first.x + tTrackStart.second.x)/2 - mFramePreprocessed.size().width/2;
             if (abs(tTrackStartPosition) < abs(tBestTrackStartPosition))
             {
                 oTrackStart = tTrackStart;
-                oTracks.first = tTrackMap.value(tTrackStart.first.x);
-                oTracks.second = tTrackMap.value(tTrackStart.second.x);
+                oTracks.first = iStitches[tTrackMap[tTrackStart.first.x]];
+                oTracks.second = iStitches[tTrackMap[tTrackStart.second.x]];
             }
         }
         return true;
@@ -414,37 +455,38 @@ bool TrackDetection::find_trackstart(const QList<Track >& iStitches, int iScanli
     return false;
 }
 
-void TrackDetection::check_validity(const QPair<Track, Track>& iOldTracks, QPair<Track, Track> iNewTracks) throw(FeatureException)
+FeatureStatus TrackDetection::check_validity(const std::pair<Track, Track>& iOldTracks, const std::pair<Track, Track>& iNewTracks)
 {
     // Check if we uberhaupt have points
     if (iNewTracks.first.size() == 0 || iNewTracks.second.size() == 0)
-        throw FeatureException("Found empty track");
+        return FeatureStatus(REASON_REJECTED, "Found empty track");
 
     // Check if first track is left and second one is right
     int tX0 = iNewTracks.first.back().x;
     int tX1 = iNewTracks.second.back().x;
     if (tX0 > tX1)
-        throw FeatureException("Left/Right not respected");
+        return FeatureStatus(REASON_REJECTED, "Left/Right not respected");
 
     // Check if new track starts at a sensible location
-    if (tX0 < 300 || tX1 > 700)
-        throw FeatureException("Track not starting at sensible location");
+    if (tX0 < frame()->cols * VALIDITY_START_LEFT || tX1 > frame()->cols * VALIDITY_START_RIGHT)
+        return FeatureStatus(REASON_REJECTED, "Track not starting at sensible location");
 
     if (iOldTracks.first.size() != 0 && iOldTracks.second.size() != 0)
     {
         // Check if the new track doesn't too much away from the previous one
         // (unless it moves towards the center of the screen, which quite likely
         // means the previous track was wrong)
-        int tOldCenter = (iOldTracks.first.back().x + iOldTracks.first.back().x) / 2;
-        int tNewCenter = (iNewTracks.first.back().x + iNewTracks.first.back().x) / 2;
-        int tFrameCenter = mFrameDebug.size().width / 2;
+        int tOldCenter = (iOldTracks.first.back().x + iOldTracks.second.back().x) / 2;
+        int tNewCenter = (iNewTracks.first.back().x + iNewTracks.second.back().x) / 2;
+        int tFrameCenter = mFramePreprocessed.size().width / 2;
         if (abs(tFrameCenter - tNewCenter) > abs(tFrameCenter - tOldCenter))
         {
             // Track is moving away from the center, check if the delta isn't too high
-            if (abs(tOldCenter - tNewCenter) > VALIDITY_TRACK_DELTA)
-                throw FeatureException("Track moving too much away from the previous one");
+            if (abs(tOldCenter - tNewCenter) > reference(VALIDITY_TRACK_DELTA))
+                return FeatureStatus(REASON_REJECTED, "Track moving too much away from the previous one");
         }
     }
+    return FeatureStatus::found();
 }
 
 
@@ -452,52 +494,25 @@ void TrackDetection::check_validity(const QPair<Track, Track>& iOldTracks, QPair
 // Auxiliary
 //
 
-// Check if two groups match
-bool TrackDetection::groups_match(const QList<Line>& iGroupA, const QList<Line>& iGroupB)
+// Check if two lines are almost parallel
+bool TrackDetection::segments_parallel(const SegmentSet& iLines, int iLineA, int iLineB)
 {
-    foreach (const Line& tLineA, iGroupA)
-    {
-        double tSlopeA = abs(atan2(tLineA.first.y - tLineA.second.y, tLineA.first.x - tLineA.second.x));
-
-        foreach (const Line& tLineB, iGroupB)
-        {
-            double tSlopeB = abs(atan2(tLineB.first.y - tLineB.second.y, tLineB.first.x - tLineB.second.x));
-
-            // Almost parallel
-            if (abs(tSlopeA - tSlopeB) <= GROUP_SLOPE_DELTA)
-            {
-                cv::Point tPointA, tPointB;
-                double tDistance = distance_segment2segment(tLineA, tLineB, tPointA, tPointB);
-                if (tDistance < GROUP_DISTANCE_DELTA)
-                    return true;
-            }
-        }
-    }
-
-    return false;
+    return (fabs(iLines.slope(iLineA) - iLines.slope(iLineB)) <= GROUP_SLOPE_DELTA);
 }
 
-// Check if two stitches match
-bool TrackDetection::stitches_match(const Track& iStitchA, const Track& iStitchB, cv::Point& oIntersection)
+// Check if two stitches match, given the slopes of the last segment of
+// the first one and of the first segment of the second one
+bool TrackDetection::stitches_match(const Track& iStitchA, float iSlopeA, const Track& iStitchB, float iSlopeB, cv::Point& oIntersection)
 {
     // Extract the relevant segments
-    Track::const_iterator tIterator = iStitchA.end();
-    Line tLineA;
-    tLineA.second = *--tIterator;
-    tLineA.first = *--tIterator;
-    tIterator = iStitchB.begin();
-    Line tLineB;
-    tLineB.first = *tIterator++;
-    tLineB.second = *tIterator++;
-
-    double tSlopeA = abs(atan2(tLineA.first.y - tLineA.second.y, tLineA.first.x - tLineA.second.x));
-    double tSlopeB = abs(atan2(tLineB.first.y - tLineB.second.y, tLineB.first.x - tLineB.second.x));
-
-    if (abs(tSlopeA - tSlopeB) <= STITCH_SLOPE_DELTA)
+    Line tLineA(iStitchA[iStitchA.size()-2], iStitchA.back());
+    Line tLineB(iStitchB[0], iStitchB[1]);
+
+    if (fabs(iSlopeA - iSlopeB) <= STITCH_SLOPE_DELTA)
     {
         int tDistanceX = abs(tLineA.second.x - tLineB.first.x);
         int tDistanceY = abs(tLineA.second.y - tLineB.first.y);
-        if (tDistanceX <= STITCH_DISTANCE_DELTA_X && tDistanceY <= STITCH_DISTANCE_DELTA_Y)
+        if (tDistanceX <= reference(STITCH_DISTANCE_DELTA_X) && tDistanceY <= reference(STITCH_DISTANCE_DELTA_Y))
         {
             oIntersection.x = (tLineA.second.x + tLineB.first.x)/2;
             oIntersection.y = (tLineA.second.y + tLineB.first.y)/2;
@@ -507,3 +522,20 @@ bool TrackDetection::stitches_match(const Track& iStitchA, const Track& iStitchB
 
     return false;
 }
+
+// Convert a track between the working and the input frame
+Track TrackDetection::toWorking(const Track& iTrack) const
+{
+    Track oTrack(iTrack.size());
+    for (size_t i = 0; i < iTrack.size(); i++)
+        oTrack[i] = Component::toWorking(iTrack[i]);
+    return oTrack;
+}
+
+Track TrackDetection::toInput(const Track& iTrack) const
+{
+    Track oTrack(iTrack.size());
+    for (size_t i = 0; i < iTrack.size(); i++)
+        oTrack[i] = Component::toInput(iTrack[i]);
+    return oTrack;
+}
@@ -9,45 +9,50 @@
 // Includes
 #include "opencv/cv.h"
 #include <cmath>
-#include <QVector>
-#include <QPair>
+#include <vector>
+#include <utility>
 #include "component.h"
 #include "framefeatures.h"
 #include "auxiliary.h"
+#include "segmentset.h"
+#include "trackmodel.h"
+#include "bandedhough.h"
 
 // Type definitions
-typedef QPair<cv::Point, cv::Point> TrackStart;
+typedef std::pair<cv::Point, cv::Point> TrackStart;
 
 class TrackDetection : public Component
 {
 public:
     // Construction and destruction
-    TrackDetection(cv::Mat const* iFrame);
+    TrackDetection(FrameContext* iContext, TrackModel* iModel = 0, BandedHough* iHough = 0);
 
     // Component interface
     void preprocess();
-    void find_features(FrameFeatures& iFrameFeatures) throw(FeatureException);
-    cv::Mat frameDebug() const;
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
 
 private:
     // Feature detection
-    QList<Line > find_lines();
-    QList<QList<Line> > find_groups(const QList<Line>& iLines);
-    QList<Line> find_representatives(const QList<QList<Line> >& iGroups);
-    QList<Track > find_stitches(const QList<Line>& iRepresentatives);
-    bool find_trackstart(const QList<Track>& iStitches, int iScanlineOffset, TrackStart& oTrackStart, QPair<Track, Track>& oTracks);
-    void check_validity(const QPair<Track, Track>& iOldTracks, QPair<Track, Track> iNewTracks) throw(FeatureException);
+    void find_lines(SegmentSet& oLines);
+    void find_groups(const SegmentSet& iLines, SegmentGroups& oGroups);
+    void find_representatives(const SegmentSet& iLines, const SegmentGroups& iGroups, SegmentSet& oRepresentatives);
+    void find_stitches(const SegmentSet& iRepresentatives, std::vector<Track>& oStitches);
+    bool find_trackstart(const std::vector<Track>& iStitches, int iScanlineOffset, TrackStart& oTrackStart, std::pair<Track, Track>& oTracks);
+    FeatureStatus check_validity(const std::pair<Track, Track>& iOldTracks, const std::pair<Track, Track>& iNewTracks);
 
     // Auxiliary methods
-    bool groups_match(const QList<Line>& iGroupA, const QList<Line>& iGroupB);
-    bool stitches_match(const Track& iStitchA, const Track& iStitchB, cv::Point& oIntersection);
+    bool segments_parallel(const SegmentSet& iLines, int iLineA, int iLineB);
+    bool stitches_match(const Track& iStitchA, float iSlopeA, const Track& iStitchB, float iSlopeB, cv::Point& oIntersection);
+    Track toWorking(const Track& iTrack) const;
+    Track toInput(const Track& iTrack) const;
 
     // Frames
     cv::Mat mFramePreprocessed;
-    cv::Mat mFrameDebug;
 
     // Member data
     cv::RNG mRng;
+    TrackModel* mModel;
+    BandedHough* mHough;
 };
 
 #endif // TRACKDETECTION_H
@@ -0,0 +1,172 @@
+//
+// Configuration
+//
+
+// Includes
+#include "trackmodel.h"
+#include <algorithm>
+
+// Model properties
+#define MODEL_MAX_MISSES 5          // consecutive frames without a detection
+#define MODEL_PROCESS_NOISE 1e-4
+#define MODEL_MEASUREMENT_NOISE 1e-3
+#define MODEL_SEGMENTS 8            // segments per sampled rail
+#define MODEL_FIT_STEP 0.01         // sampling distance along a detected rail
+
+
+//
+// Construction and destruction
+//
+
+TrackModel::TrackModel()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        // Constant model: the coefficients are only expected to drift
+        mFilters[i].init(3, 3, 0, CV_64F);
+        cv::setIdentity(mFilters[i].transitionMatrix);
+        cv::setIdentity(mFilters[i].measurementMatrix);
+        cv::setIdentity(mFilters[i].processNoiseCov, cv::Scalar::all(MODEL_PROCESS_NOISE));
+        cv::setIdentity(mFilters[i].measurementNoiseCov, cv::Scalar::all(MODEL_MEASUREMENT_NOISE));
+    }
+    reset();
+}
+
+
+//
+// Model state
+//
+
+void TrackModel::reset()
+{
+    mInitialised = false;
+    mMisses = 0;
+    mTop = 1;
+    mBottom = 1;
+}
+
+bool TrackModel::valid() const
+{
+    return mInitialised && mMisses <= MODEL_MAX_MISSES;
+}
+
+
+//
+// Filtering
+//
+
+void TrackModel::predict()
+{
+    if (!mInitialised)
+        return;
+
+    for (int i = 0; i < 2; i++)
+        mFilters[i].predict();
+}
+
+// Fold a pair of detected rails (left first) into the model
+void TrackModel::correct(const std::pair<Track, Track>& iTracks, int iFrameHeight)
+{
+    cv::Mat tMeasurements[2];
+    if (!fit(iTracks.first, iFrameHeight, tMeasurements[0]) || !fit(iTracks.second, iFrameHeight, tMeasurements[1]))
+    {
+        miss();
+        return;
+    }
+
+    // Tracks run from the top of the frame down to the tram
+    mTop = std::min(iTracks.first.front().y, iTracks.second.front().y) / (double) iFrameHeight;
+    mBottom = std::max(iTracks.first.back().y, iTracks.second.back().y) / (double) iFrameHeight;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!valid())
+        {
+            // (Re-)initialize the filter on the measurement itself
+            tMeasurements[i].copyTo(mFilters[i].statePost);
+            tMeasurements[i].copyTo(mFilters[i].statePre);
+            cv::setIdentity(mFilters[i].errorCovPost, cv::Scalar::all(MODEL_MEASUREMENT_NOISE));
+        }
+        else
+            mFilters[i].correct(tMeasurements[i]);
+    }
+    mInitialised = true;
+    mMisses = 0;
+}
+
+void TrackModel::miss()
+{
+    mMisses++;
+}
+
+
+//
+// Evaluation
+//
+
+// Horizontal position of a rail at a given row
+double TrackModel::x(int iRail, double iRow, int iFrameHeight) const
+{
+    const cv::Mat& tState = mFilters[iRail].statePost;
+    double v = iRow / iFrameHeight;
+    return (tState.at<double>(0) + tState.at<double>(1) * v + tState.at<double>(2) * v * v) * iFrameHeight;
+}
+
+// Sample both rails as polylines, over the range they were last seen in
+std::pair<Track, Track> TrackModel::rails(int iFrameHeight) const
+{
+    return std::pair<Track, Track>(rail(0, iFrameHeight), rail(1, iFrameHeight));
+}
+
+
+//
+// Auxiliary
+//
+
+Track TrackModel::rail(int iRail, int iFrameHeight) const
+{
+    Track oRail;
+    oRail.reserve(MODEL_SEGMENTS + 1);
+    for (int i = 0; i <= MODEL_SEGMENTS; i++)
+    {
+        double tRow = (mTop + (mBottom - mTop) * i / MODEL_SEGMENTS) * iFrameHeight;
+        oRail.push_back(cv::Point(cvRound(x(iRail, tRow, iFrameHeight)), cvRound(tRow)));
+    }
+    return oRail;
+}
+
+// Least squares fit of a parabola through a polyline, sampled at regular
+// distances so long segments weigh more than short ones
+bool TrackModel::fit(const Track& iTrack, int iFrameHeight, cv::Mat& oCoefficients) const
+{
+    std::vector<double> tRows, tColumns;
+    for (size_t i = 0; i + 1 < iTrack.size(); i++)
+    {
+        cv::Point2d tA(iTrack[i].x / (double) iFrameHeight, iTrack[i].y / (double) iFrameHeight);
+        cv::Point2d tB(iTrack[i+1].x / (double) iFrameHeight, iTrack[i+1].y / (double) iFrameHeight);
+        int tSamples = std::max(1, (int) (cv::norm(tB - tA) / MODEL_FIT_STEP));
+        for (int j = 0; j < tSamples; j++)
+        {
+            double t = (double) j / tSamples;
+            tColumns.push_back(tA.x + t * (tB.x - tA.x));
+            tRows.push_back(tA.y + t * (tB.y - tA.y));
+        }
+    }
+    if (iTrack.size() > 0)
+    {
+        tColumns.push_back(iTrack.back().x / (double) iFrameHeight);
+        tRows.push_back(iTrack.back().y / (double) iFrameHeight);
+    }
+    if (tRows.size() < 3)
+        return false;
+
+    cv::Mat tDesign(tRows.size(), 3, CV_64F), tTarget(tRows.size(), 1, CV_64F);
+    for (size_t i = 0; i < tRows.size(); i++)
+    {
+        tDesign.at<double>(i, 0) = 1;
+        tDesign.at<double>(i, 1) = tRows[i];
+        tDesign.at<double>(i, 2) = tRows[i] * tRows[i];
+        tTarget.at<double>(i) = tColumns[i];
+    }
+    return cv::solve(tDesign, tTarget, oCoefficients, cv::DECOMP_SVD);
+}
@@ -0,0 +1,53 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef TRACKMODEL_H
+#define TRACKMODEL_H
+
+// Includes
+#include "opencv/cv.h"
+#include <utility>
+#include "framefeatures.h"
+
+/*
+  The TrackModel keeps a temporal model of both rails, which persists
+  across frames. Every rail is a parabola x = a + b*y + c*y², in coordinates
+  normalized by the frame height (so the model doesn't depend on the working
+  resolution), and its coefficients are filtered with a Kalman filter. The
+  model predicts where the rails will be in the next frame, which lets track
+  detection restrict its search to a narrow band around them.
+  */
+class TrackModel
+{
+public:
+    // Construction and destruction
+    TrackModel();
+
+    // Model state
+    void reset();
+    bool valid() const;
+
+    // Filtering
+    void predict();
+    void correct(const std::pair<Track, Track>& iTracks, int iFrameHeight);
+    void miss();
+
+    // Evaluation
+    double x(int iRail, double iRow, int iFrameHeight) const;
+    std::pair<Track, Track> rails(int iFrameHeight) const;
+
+private:
+    // Auxiliary
+    bool fit(const Track& iTrack, int iFrameHeight, cv::Mat& oCoefficients) const;
+    Track rail(int iRail, int iFrameHeight) const;
+
+    // Member data
+    cv::KalmanFilter mFilters[2];
+    bool mInitialised;
+    unsigned int mMisses;
+    double mTop, mBottom;
+};
+
+#endif // TRACKMODEL_H
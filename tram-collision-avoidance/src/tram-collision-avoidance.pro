@@ -1,8 +1,11 @@
-QT += core gui opengl
+QT += core gui opengl network
 
 CONFIG += link_pkgconfig
 PKGCONFIG += opencv
 
+# POSIX shared memory
+LIBS += -lrt
+
 SOURCES += \
     main.cpp \
     trackdetection.cpp \
@@ -12,7 +15,29 @@ SOURCES += \
     pedestriandetection.cpp \
     vehicledetection.cpp \
     auxiliary.cpp \
-    tramdistance.cpp
+    tramdistance.cpp \
+    framecontext.cpp \
+    debugcanvas.cpp \
+    videorecorder.cpp \
+    scheduler.cpp \
+    trackmodel.cpp \
+    bandedhough.cpp \
+    objecttracker.cpp \
+    timetocollision.cpp \
+    groundplane.cpp \
+    collisionrisk.cpp \
+    framegrabber.cpp \
+    resources.cpp \
+    pipeline.cpp \
+    workpool.cpp \
+    streamserver.cpp \
+    framearena.cpp \
+    bufferpool.cpp \
+    featurepublisher.cpp \
+    logger.cpp \
+    metrics.cpp \
+    alertoutput.cpp \
+    sharedframering.cpp
 
 HEADERS += \
     trackdetection.h \
@@ -25,7 +50,33 @@ HEADERS += \
     tramdetection.h \
     pedestriandetection.h \
     vehicledetection.h \
-    tramdistance.h
+    tramdistance.h \
+    framecontext.h \
+    debugcanvas.h \
+    videorecorder.h \
+    scheduler.h \
+    trackmodel.h \
+    bandedhough.h \
+    objecttracker.h \
+    timetocollision.h \
+    groundplane.h \
+    collisionrisk.h \
+    framegrabber.h \
+    resources.h \
+    pipeline.h \
+    workpool.h \
+    streamserver.h \
+    segmentset.h \
+    framearena.h \
+    bufferpool.h \
+    featurepublisher.h \
+    featurestatus.h \
+    logger.h \
+    metrics.h \
+    alertmessage.h \
+    alertoutput.h \
+    sharedframes.h \
+    sharedframering.h
 
 profile {
     QMAKE_CXXFLAGS_DEBUG += -pg
@@ -4,24 +4,29 @@
 
 // Includes
 #include "tramdetection.h"
-#include <QString>
 #include <iostream>
+#include <algorithm>
 
 // Feature properties
+#define TRAM_WORKING_HEIGHT REFERENCE_HEIGHT
 #define MAX_THRESHOLD 0.895
 #define MIN_THRESHOLD 0
 #define DELTA_X 100
 #define DELTA_Y 100
+#define SCALE_STEP 1.05         // relative template scales tried around a match
+#define SCALE_MIN 0.5
+#define SCALE_MAX 3.0
+#define SCALE_MARGIN 8          // search margin around a match, in reference pixels
 
 //
 // Construction and destruction
 //
 
-TramDetection::TramDetection(cv::Mat const* iFrame) : Component(iFrame)
+TramDetection::TramDetection(FrameContext* iContext, const cv::Mat& iTemplate) : Component(iContext, TRAM_WORKING_HEIGHT), mTemplate(iTemplate)
 {
     // Initializing ROI
-    mROIPoint = cv::Point(iFrame->size().width*0.33,0);
-    mROISize = cv::Size(iFrame->size().width*0.33,iFrame->size().height);
+    mROIPoint = cv::Point(frame()->size().width*0.33,0);
+    mROISize = cv::Size(frame()->size().width*0.33,frame()->size().height);
 }
 
 //
@@ -46,23 +51,34 @@ void TramDetection::preprocess()
 
 
     // Save final frame
-    mFrameDebug = frame()->clone();
-    mFramePreprocessed = frame()->clone();
+    debug().setBackground(*frame());
+    mFramePreprocessed = *frame();
 }
 
-void TramDetection::find_features(FrameFeatures &iFrameFeatures) throw(FeatureException) {
+FeatureStatus TramDetection::find_features(FrameFeatures &iFrameFeatures) {
     // Cropping
-    cv::Mat cropFrame = frame()->clone();
-
     cv::Rect tROI(mROIPoint,mROISize);
 
-    mFrameDebug = cropFrame(tROI);
-    mFramePreprocessed = cropFrame(tROI);
-
-    // Loading template to match with the mPreProcessedFrame
-    cv::Mat tTemplate = cv::imread("../res/tram_back004.jpg");
-    if( !tTemplate.data )
-        throw std::exception();
+    debug().setBackground((*frame())(tROI));
+    mFramePreprocessed = (*frame())(tROI);
+
+    // Template to match with the mPreProcessedFrame
+    const cv::Mat& tTemplateOriginal = mTemplate;
+    if( !tTemplateOriginal.data )
+        return FeatureStatus(REASON_NO_RESOURCE, "Could not load tram template");
+
+    // The template was cut from footage at reference resolution, and gets
+    // matched at the scale the tram was last seen at (resizing into a new
+    // buffer, as the original is shared with other streams)
+    cv::Mat tTemplate;
+    double tScale = iFrameFeatures.tramScale;
+    if (frame()->rows != REFERENCE_HEIGHT || tScale != 1)
+    {
+        double tTemplateScale = reference(1) * tScale;
+        cv::resize(tTemplateOriginal, tTemplate, cv::Size(), tTemplateScale, tTemplateScale, cv::INTER_AREA);
+    }
+    else
+        tTemplate = tTemplateOriginal;
 
     cv::Mat tFrame;
 
@@ -95,7 +111,7 @@ void TramDetection::find_features(FrameFeatures &iFrameFeatures) throw(FeatureEx
         //        std::cout << "MinValue=" << tMinValue;
 
         if(tMinValue > MIN_THRESHOLD){
-            throw FeatureException("no tram found (" + QString::number(tMaxValue) + ")");
+            return FeatureStatus(REASON_NOT_FOUND, "no tram found", tMinValue);
         }
         // Use global minimum
         tLocationCropped = tMinLocation;
@@ -106,19 +122,56 @@ void TramDetection::find_features(FrameFeatures &iFrameFeatures) throw(FeatureEx
         //        std::cout << "MaxValue=" << tMaxValue;
 
         if(tMaxValue < MAX_THRESHOLD){
-            throw FeatureException("no tram found (" + QString::number(tMaxValue) + ")");
+            return FeatureStatus(REASON_NOT_FOUND, "no tram found", tMaxValue);
         }
         // Use global maximum
         tLocationCropped = tMaxLocation;
         iFrameFeatures.maxValue = tMaxValue;
+
+        // Try slightly different scales around the match, which tells how
+        // fast the tram grows
+        const double tFactors[] = { 1/SCALE_STEP, SCALE_STEP };
+        cv::Point tCenter(tLocationCropped.x + tTemplate.cols/2, tLocationCropped.y + tTemplate.rows/2);
+        int tMargin = std::max(1, (int) reference(SCALE_MARGIN));
+        cv::Mat tBestTemplate = tTemplate;
+        double tBestScale = tScale;
+        for (int i = 0; i < 2; i++)
+        {
+            double tCandidateScale = tScale * tFactors[i];
+            if (tCandidateScale < SCALE_MIN || tCandidateScale > SCALE_MAX)
+                continue;
+            cv::Mat tCandidate;
+            cv::resize(tTemplateOriginal, tCandidate, cv::Size(), reference(1) * tCandidateScale, reference(1) * tCandidateScale, cv::INTER_AREA);
+
+            cv::Rect tWindow(tCenter.x - tCandidate.cols/2 - tMargin, tCenter.y - tCandidate.rows/2 - tMargin,
+                             tCandidate.cols + 2*tMargin, tCandidate.rows + 2*tMargin);
+            tWindow &= cv::Rect(0, 0, mFramePreprocessed.cols, mFramePreprocessed.rows);
+            if (tWindow.width < tCandidate.cols || tWindow.height < tCandidate.rows)
+                continue;
+
+            cv::Mat tResult;
+            double tValue;
+            cv::Point tPosition;
+            cv::matchTemplate(mFramePreprocessed(tWindow), tCandidate, tResult, method[currMethod]);
+            cv::minMaxLoc(tResult, 0, &tValue, 0, &tPosition);
+            if (tValue > tMaxValue)
+            {
+                tMaxValue = tValue;
+                tLocationCropped = tWindow.tl() + tPosition;
+                tBestTemplate = tCandidate;
+                tBestScale = tCandidateScale;
+            }
+        }
+        tTemplate = tBestTemplate;
+        iFrameFeatures.tramScale = tBestScale;
     }
 
     cv::Point tOppositeLocactionCropped;
-    // Finding opposite corner to draw the rectangle for cropped mFrameDebug
+    // Finding opposite corner to draw the rectangle for the cropped debug frame
     tOppositeLocactionCropped.y = tLocationCropped.y + tTemplate.size().height;
     tOppositeLocactionCropped.x = tLocationCropped.x + tTemplate.size().width;
 
-    cv::rectangle(mFrameDebug, tLocationCropped, tOppositeLocactionCropped, cv::Scalar(0, 255, 0), 1);
+    debug().rectangle(tLocationCropped, tOppositeLocactionCropped, cv::Scalar(0, 255, 0), 1);
 
     // Adjusting the point to fit on the original frame
     cv::Point tLocation = cv::Point(tLocationCropped.x + mROIPoint.x, tLocationCropped.y + mROIPoint.y);
@@ -143,8 +196,9 @@ void TramDetection::find_features(FrameFeatures &iFrameFeatures) throw(FeatureEx
     } else {
         iFrameFeatures.maxValue = tMaxValue;
     }
-    iFrameFeatures.location = tLocation;
-    iFrameFeatures.tram = cv::Rect(tLocation, tTemplate.size());
+    iFrameFeatures.location = toInput(tLocation);
+    iFrameFeatures.tram = toInput(cv::Rect(tLocation, tTemplate.size()));
+    return FeatureStatus::found();
 }
 
 void TramDetection::calculate_croparea(FrameFeatures &iFrameFeatures){
@@ -203,8 +257,3 @@ void TramDetection::calculate_croparea(FrameFeatures &iFrameFeatures){
 //    //    cv::line(mFrameDebug, iFrameFeatures.rightLowerLeft,iFrameFeatures.rightUpperRight, cv::Scalar(0, 0, 255));
 //    cv::line(mFramePreprocessed, mRightLowerLeft,mRightUpperRight, cv::Scalar(0, 0, 255));
 }
-
-cv::Mat TramDetection::frameDebug() const
-{
-    return mFrameDebug;
-}
@@ -12,20 +12,18 @@
 class TramDetection : public Component
 {
 public:
-    TramDetection();
     // Construction and destruction
-    TramDetection(cv::Mat const* iFrame);
+    TramDetection(FrameContext* iContext, const cv::Mat& iTemplate);
 
     // Component interface
     void preprocess();
-    void find_features(FrameFeatures& iFrameFeatures) throw(FeatureException);
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
     void calculate_croparea(FrameFeatures &iFrameFeatures);
-    cv::Mat frameDebug() const;
 
 private:
     // Frames
     cv::Mat mFramePreprocessed;
-    cv::Mat mFrameDebug;
+    cv::Mat mTemplate;
 
     cv::Point mROIPoint;
     cv::Size mROISize;
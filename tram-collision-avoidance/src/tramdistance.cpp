@@ -4,21 +4,21 @@
 
 // Includes
 #include "tramdistance.h"
-#include <iostream>
+#include <sstream>
+
+// Feature properties
+#define DISTANCE_MARKER_STEP 10     // in meters, between markers on the debug frame
+#define DISTANCE_MARKER_MAX 100
 
-//Feature properties
-#define TRACK_WIDTH 0.70  // the distance in meters betweens the tracks
-#define DISTANCE_DEPTH 200 // distance shown in depth off screen in meters
-#define TRAM_WIDTH 2.5    // widths in meter of a tram
 
 //
 // Construction and destruction
 //
 
-TramDistance::TramDistance(cv::Mat const* iFrame) : Component(iFrame)
+TramDistance::TramDistance(FrameContext* iContext, const GroundPlane* iGroundPlane) : Component(iContext), mGroundPlane(iGroundPlane)
 {
-    frameWidth = iFrame->cols;
-    frameHeight = iFrame->rows;
+    frameWidth = frame()->cols;
+    frameHeight = frame()->rows;
 }
 
 
@@ -28,26 +28,40 @@ TramDistance::TramDistance(cv::Mat const* iFrame) : Component(iFrame)
 
 void TramDistance::preprocess()
 {
-    mFrameDebug = (*frame()).clone();
+    debug().setBackground(*frame());
 }
 
-void TramDistance::find_features(FrameFeatures& iFrameFeatures) throw(FeatureException)
+FeatureStatus TramDistance::find_features(FrameFeatures& iFrameFeatures)
 {
     cv::Point trackHalfX;
     trackHalfX.y = frameHeight;
 
-    // tracks were found
-    if(iFrameFeatures.tracks.first.isEmpty()) {
-        std::cout << "No tracks found "  << std::endl;
+    // no tracks so assume in half of the screen
+    if(iFrameFeatures.tracks.first.empty()) {
         trackHalfX.x = frameWidth/2;
         iFrameFeatures.trackHalfX = trackHalfX;
     }
-    // no tracks so assume in half of the screen
+    // tracks were found
     else {
-        trackHalfX.x = (iFrameFeatures.tracks.first.last().x + iFrameFeatures.tracks.second.last().x)/2;
+        trackHalfX.x = (iFrameFeatures.tracks.first.back().x + iFrameFeatures.tracks.second.back().x)/2;
         iFrameFeatures.trackHalfX = trackHalfX;
     }
 
+    // Mark some distances, which shows how well the calibration fits
+    if (debug().enabled() && mGroundPlane->calibrated())
+    {
+        for (int tDepth = DISTANCE_MARKER_STEP; tDepth <= DISTANCE_MARKER_MAX; tDepth += DISTANCE_MARKER_STEP)
+        {
+            int tRow = mGroundPlane->row(tDepth);
+            if (tRow < 0)
+                break;
+            debug().line(cv::Point(0, tRow), cv::Point(frameWidth, tRow), cv::Scalar(255, 255, 0), 1);
+            std::ostringstream tLabel;
+            tLabel << tDepth << " m";
+            debug().text(tLabel.str(), cv::Point(5, tRow - 3), cv::Scalar(255, 255, 0));
+        }
+    }
+
     // tram was found
     if(iFrameFeatures.tram.width != 0) {
         cv::Point tramHalfX;
@@ -55,31 +69,19 @@ void TramDistance::find_features(FrameFeatures& iFrameFeatures) throw(FeatureExc
         tramHalfX.x = iFrameFeatures.tram.x + iFrameFeatures.tram.width/2;
         iFrameFeatures.tramHalfX = tramHalfX;
 
-        double ratio = 1.0 *(frameHeight - tramHalfX.y) / frameHeight;
-        //calculate the depth distance
-        double yDistance;
-        yDistance = ratio * ratio * ratio * DISTANCE_DEPTH;
-
-        // calculate the total width is shown at that current line
-        double widthDistance;
-        widthDistance = frameWidth * TRAM_WIDTH / iFrameFeatures.tram.width;
-
-        double xDistance;
-        xDistance = (trackHalfX.x - tramHalfX.x) * widthDistance / frameWidth ;
-
-        double totalDistance = yDistance * yDistance + xDistance * xDistance;
-        std::cout << "totalDist: " << sqrt(totalDistance) << std::endl;
-
-        iFrameFeatures.tramDistance = sqrt(totalDistance);
+        // The bottom of the tram stands on the ground
+        iFrameFeatures.tramDistance = mGroundPlane->distance(tramHalfX);
+        if (iFrameFeatures.tramDistance == 0)
+        {
+            if (mGroundPlane->calibrated())
+                return FeatureStatus(REASON_REJECTED, "Tram beyond the horizon");
+            return FeatureStatus(REASON_UNCALIBRATED, "Ground plane not calibrated");
+        }
     }
     // no tram found
     else{
         iFrameFeatures.tramHalfX = trackHalfX;
         iFrameFeatures.tramDistance = 0;
     }
-}
-
-cv::Mat TramDistance::frameDebug() const
-{
-    return mFrameDebug;
+    return FeatureStatus::found();
 }
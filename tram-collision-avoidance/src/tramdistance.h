@@ -12,19 +12,20 @@
 #include <ctype.h>
 #include "component.h"
 #include "framefeatures.h"
+#include "groundplane.h"
 
 class TramDistance : public Component
 {
 public:
     // Construction and destruction
-    TramDistance(cv::Mat const* iFrame);
+    TramDistance(FrameContext* iContext, const GroundPlane* iGroundPlane);
 
     // Component interface
     void preprocess();
-    void find_features(FrameFeatures& iFrameFeatures) throw(FeatureException);
-    cv::Mat frameDebug() const;
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
 
 private:
+    const GroundPlane* mGroundPlane;
     cv::Mat mFrameCropped;
 
     int frameHeight;
@@ -32,7 +33,6 @@ private:
 
     // Frames
     cv::Mat mFramePreprocessed;
-    cv::Mat mFrameDebug;
 };
 
 #endif // TRAMDISTANCE_H
@@ -4,8 +4,12 @@
 
 // Includes
 #include "vehicledetection.h"
+#include <algorithm>
+#include "framearena.h"
+#include "bufferpool.h"
 
-//Feature properties
+//Feature properties (lengths in pixels of the reference resolution)
+#define VEHICLE_WORKING_HEIGHT REFERENCE_HEIGHT
 #define VEHICLE_sliderPos 35
 
 #define VEHICLE_LOW_BOUND 15
@@ -16,7 +20,7 @@
 // Construction and destruction
 //
 
-VehicleDetection::VehicleDetection(cv::Mat const* iFrame) : Component(iFrame)
+VehicleDetection::VehicleDetection(FrameContext* iContext, double iDetail) : Component(iContext, VEHICLE_WORKING_HEIGHT, iDetail)
 {
     adjustedX = 0;
     tracksWidth = -1;
@@ -29,33 +33,32 @@ VehicleDetection::VehicleDetection(cv::Mat const* iFrame) : Component(iFrame)
 
 void VehicleDetection::preprocess()
 {
-    mFrameDebug = (*frame()).clone();
+    debug().setBackground(*frame());
 }
 
-void VehicleDetection::find_features(FrameFeatures& iFrameFeatures) throw(FeatureException)
+FeatureStatus VehicleDetection::find_features(FrameFeatures& iFrameFeatures)
 {
     //Detecting current tracks width
-    if (iFrameFeatures.tracks.first.length() > 1 && iFrameFeatures.tracks.second.length() > 1) {
-        int x1 = iFrameFeatures.tracks.first[0].x;
-        int y1 = iFrameFeatures.tracks.first[0].y;
-        int x2 = iFrameFeatures.tracks.second[0].x;
-        int y2 = iFrameFeatures.tracks.second[0].y;
+    if (iFrameFeatures.tracks.first.size() > 1 && iFrameFeatures.tracks.second.size() > 1) {
+        cv::Point tFirst = toWorking(iFrameFeatures.tracks.first[0]);
+        cv::Point tSecond = toWorking(iFrameFeatures.tracks.second[0]);
+        int x1 = tFirst.x;
+        int y1 = tFirst.y;
+        int x2 = tSecond.x;
+        int y2 = tSecond.y;
 
         tracksWidth = sqrt(pow(x2-x1, 2) + pow(y2-y1, 2));
         tracksStartCol = x1;
         tracksEndCol = x2;
     }
+    //Region around the path of the tram, if we know it
+    mCorridor = cv::Rect(toWorking(iFrameFeatures.corridorBounds.tl()), toWorking(iFrameFeatures.corridorBounds.br()));
     //Crop the frame = faster detection
     cropFrame();
     //Detect wheels (ellipse)
     detectWheels();
     //Detect cars from wheels
-    detectVehiclesFromWheels(iFrameFeatures);
-}
-
-cv::Mat VehicleDetection::frameDebug() const
-{
-    return mFrameDebug;
+    return detectVehiclesFromWheels(iFrameFeatures);
 }
 
 
@@ -107,30 +110,41 @@ private:
 
 void VehicleDetection::cropFrame() {
     //Only interested in the area next to the tracks
-    if (tracksWidth > -1) {
+    if (mCorridor.width > 0 && mCorridor.x < frame()->cols) {
+        adjustedX = std::max(0, mCorridor.x);
+        cv::Range rowRange(0, frame()->rows);
+        cv::Range colRange(adjustedX, std::min(frame()->cols, mCorridor.x + mCorridor.width));
+        mFrameCropped = cv::Mat(frameGray(), rowRange, colRange);
+    } else if (tracksWidth > -1) {
         adjustedX = tracksStartCol - 1.2*tracksWidth;
         if (adjustedX < 0) {
             adjustedX = 0;
         }
         cv::Range rowRange(0, frame()->rows);
         cv::Range colRange(adjustedX, (tracksEndCol + 1.2*tracksWidth > frame()->cols?frame()->cols:tracksEndCol + 1.2*tracksWidth));
-        mFrameCropped = cv::Mat(*frame(), rowRange, colRange);
+        mFrameCropped = cv::Mat(frameGray(), rowRange, colRange);
     } else {
-        mFrameCropped = mFrameDebug.clone();
+        mFrameCropped = frameGray();
     }
 }
 
 void VehicleDetection::detectWheels() {
-    cv::Mat img;
-    cv::cvtColor(mFrameCropped, img, CV_RGB2GRAY);
-    std::list<Rectangle*> lst;
+    cv::Mat img = mFrameCropped;
+    //The candidate wheels only live during this frame, so they (and the list
+    //holding them) come from the frame arena
+    FrameArena& arena = FrameArena::local();
+    ArenaList<Rectangle*>::type lst;
     lst.resize(50, 0);
 
+    //The contours and the thresholded image get reused for every threshold
+    std::vector<std::vector<cv::Point> > contours;
+    cv::Mat bimage;
+    bimage.allocator = BufferPool::instance();
+
     int start = 5; int end = 100;
     for (int i = start; i < end; i += 15) {
         //Find all contours
-        std::vector<std::vector<cv::Point> > contours;
-        cv::Mat bimage = img >= i;
+        cv::compare(img, cv::Scalar(i), bimage, cv::CMP_GE);
         findContours(bimage, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_TC89_L1 );
 
         for(size_t i = 0; i < contours.size(); i++)
@@ -157,7 +171,7 @@ void VehicleDetection::detectWheels() {
             if( box.size.height < box.size.width)
                 continue;
 
-            if (MIN(box.size.width, box.size.height) < VEHICLE_LOW_BOUND || MAX(box.size.width, box.size.height) > VEHICLE_HIGH_BOUND)
+            if (MIN(box.size.width, box.size.height) < reference(VEHICLE_LOW_BOUND) || MAX(box.size.width, box.size.height) > reference(VEHICLE_HIGH_BOUND))
                 continue;
 
             if (tracksWidth > -1) {
@@ -171,12 +185,12 @@ void VehicleDetection::detectWheels() {
             cv::Point p = box.center;
             p.x += adjustedX;
             //Draw ellipse on debug
-            cv::ellipse(mFrameDebug, p, box.size*0.5f, box.angle, 0, 360, cv::Scalar(0,255,255), 1, CV_AA);
+            debug().ellipse(p, box.size*0.5f, box.angle, cv::Scalar(0,255,255), 1, CV_AA);
 
             //Check if it does not overlap any existing wheel (that's not possible!)
-            Rectangle * r = new Rectangle(box);
+            Rectangle * r = new (arena.allocate(sizeof(Rectangle))) Rectangle(box);
 
-            std::list<Rectangle*>::iterator it;
+            ArenaList<Rectangle*>::type::iterator it;
             bool add = true;
             it=lst.begin();
             while (it != lst.end()) {
@@ -198,7 +212,7 @@ void VehicleDetection::detectWheels() {
         }
     }
     //Save the found wheels
-    std::list<Rectangle*>::iterator it;
+    ArenaList<Rectangle*>::type::iterator it;
     for ( it=lst.begin() ; it != lst.end(); it++ ) {
         if ((*it) != 0) {
             cv::Rect r = (*it)->getRect();
@@ -207,7 +221,7 @@ void VehicleDetection::detectWheels() {
         }
     }
 }
-void VehicleDetection::detectVehiclesFromWheels(FrameFeatures& iFrameFeatures) {
+FeatureStatus VehicleDetection::detectVehiclesFromWheels(FrameFeatures& iFrameFeatures) {
     bool added = false;
     std::vector<int> connected;
     std::vector<int> weights;
@@ -273,17 +287,18 @@ void VehicleDetection::detectVehiclesFromWheels(FrameFeatures& iFrameFeatures) {
                     iFrameFeatures.vehicles.clear();
                 }
 
-                iFrameFeatures.vehicles.push_back(r);
+                iFrameFeatures.vehicles.push_back(toInput(r));
 
                 added = true;
                 //std::cout<<i<<" met "<<connected[i]<<std::endl;
             }
         }
     }
-    //If no features are found: exception
+    //If no features are found: say so
     if (!added) {
-        throw FeatureException("no vehicles found");
+        return FeatureStatus(REASON_NOT_FOUND, "no vehicles found");
     }
+    return FeatureStatus::found();
 }
 
 
@@ -21,27 +21,26 @@ class VehicleDetection : public Component
 {
 public:
     // Construction and destruction
-    VehicleDetection(cv::Mat const* iFrame);
+    VehicleDetection(FrameContext* iContext, double iDetail = 1.0);
 
     // Component interface
     void preprocess();
-    void find_features(FrameFeatures& iFrameFeatures) throw(FeatureException);
-    cv::Mat frameDebug() const;
+    FeatureStatus find_features(FrameFeatures& iFrameFeatures);
 
 private:
     // Feature detection
     void cropFrame();
     void detectWheels();
-    void detectVehiclesFromWheels(FrameFeatures& iFrameFeatures);
+    FeatureStatus detectVehiclesFromWheels(FrameFeatures& iFrameFeatures);
     std::vector<cv::Rect> vehicles;
     int tracksWidth, tracksStartCol, tracksEndCol;
     int adjustedX;
 
     cv::Mat mFrameCropped;
+    cv::Rect mCorridor;
 
     // Frames
     cv::Mat mFramePreprocessed;
-    cv::Mat mFrameDebug;
 };
 
 #endif // VEHICLEDETECTION_H
@@ -0,0 +1,155 @@
+//
+// Configuration
+//
+
+// Includes
+#include "videorecorder.h"
+#include <QMutexLocker>
+
+
+//
+// Construction and destruction
+//
+
+VideoRecorder::VideoRecorder(size_t iCapacity) : mPolicy(DROP), mRecording(false), mRing(iCapacity), mHead(0), mCount(0), mStopping(false), mWritten(0), mDropped(0)
+{
+}
+
+VideoRecorder::~VideoRecorder()
+{
+    close();
+}
+
+
+//
+// Recording
+//
+
+bool VideoRecorder::open(const std::string& iFilename, double iFps, cv::Size iSize, Policy iPolicy)
+{
+    close();
+
+    // Some containers don't report their frame rate
+    if (iFps <= 0)
+        iFps = 25;
+    if (!mWriter.open(iFilename, CV_FOURCC('M', 'J', 'P', 'G'), iFps, iSize, true))
+        return false;
+
+    mSize = iSize;
+    mPolicy = iPolicy;
+    mHead = 0;
+    mCount = 0;
+    mStopping = false;
+    mWritten = 0;
+    mDropped = 0;
+    mRecording = true;
+    start();
+    return true;
+}
+
+// Stop accepting frames, let the encoder flush what's still queued, and
+// finalize the file.
+void VideoRecorder::close()
+{
+    if (!mRecording)
+        return;
+
+    {
+        QMutexLocker tLocker(&mMutex);
+        mStopping = true;
+        mNotEmpty.wakeAll();
+        mNotFull.wakeAll();
+    }
+    wait();
+
+    mWriter.release();
+    mRecording = false;
+}
+
+bool VideoRecorder::isRecording() const
+{
+    return mRecording;
+}
+
+// Queue a frame for encoding. Returns false if the frame got dropped.
+bool VideoRecorder::push(const cv::Mat& iFrame)
+{
+    if (!mRecording)
+        return false;
+
+    QMutexLocker tLocker(&mMutex);
+    while (mCount == mRing.size())
+    {
+        if (mPolicy == DROP || mStopping)
+        {
+            mDropped++;
+            return false;
+        }
+        mNotFull.wait(&mMutex);
+    }
+
+    mRing[(mHead + mCount) % mRing.size()] = iFrame;
+    mCount++;
+    mNotEmpty.wakeOne();
+    return true;
+}
+
+
+//
+// Statistics
+//
+
+unsigned long VideoRecorder::written()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mWritten;
+}
+
+unsigned long VideoRecorder::dropped()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mDropped;
+}
+
+size_t VideoRecorder::pending()
+{
+    QMutexLocker tLocker(&mMutex);
+    return mCount;
+}
+
+
+//
+// Encoder thread
+//
+
+void VideoRecorder::run()
+{
+    forever
+    {
+        // Fetch the oldest frame
+        cv::Mat tFrame;
+        {
+            QMutexLocker tLocker(&mMutex);
+            while (mCount == 0 && !mStopping)
+                mNotEmpty.wait(&mMutex);
+            if (mCount == 0)
+                return;
+
+            tFrame = mRing[mHead];
+            mRing[mHead] = cv::Mat();
+            mHead = (mHead + 1) % mRing.size();
+            mCount--;
+            mNotFull.wakeOne();
+        }
+
+        // Debug views don't necessarily match the output geometry
+        if (tFrame.size() != mSize)
+            cv::resize(tFrame, tFrame, mSize);
+        if (tFrame.channels() == 1)
+            cv::cvtColor(tFrame, tFrame, CV_GRAY2BGR);
+        mWriter << tFrame;
+
+        QMutexLocker tLocker(&mMutex);
+        mWritten++;
+    }
+}
@@ -0,0 +1,71 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef VIDEORECORDER_H
+#define VIDEORECORDER_H
+
+// Includes
+#include "opencv/cv.h"
+#include "highgui.h"
+#include <string>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+/*
+  The VideoRecorder encodes frames on a dedicated thread. Frames are handed
+  over through a bounded ring buffer, so the processing loop only pays for
+  queueing a reference to the frame. When the encoder can't keep up, the
+  policy decides whether new frames get dropped, or whether the producer
+  blocks until a slot frees up.
+
+  Frames are referenced, not copied: don't modify a frame after pushing it.
+  */
+class VideoRecorder : public QThread
+{
+public:
+    // Enumerations
+    enum Policy {
+        DROP,
+        BLOCK
+    };
+
+    // Construction and destruction
+    VideoRecorder(size_t iCapacity = 32);
+    ~VideoRecorder();
+
+    // Recording
+    bool open(const std::string& iFilename, double iFps, cv::Size iSize, Policy iPolicy = DROP);
+    void close();
+    bool isRecording() const;
+    bool push(const cv::Mat& iFrame);
+
+    // Statistics
+    unsigned long written();
+    unsigned long dropped();
+    size_t pending();
+
+protected:
+    // Encoder thread
+    void run();
+
+private:
+    // Member data
+    cv::VideoWriter mWriter;
+    cv::Size mSize;
+    Policy mPolicy;
+    bool mRecording;
+
+    // Ring buffer
+    std::vector<cv::Mat> mRing;
+    size_t mHead, mCount;
+    bool mStopping;
+    unsigned long mWritten, mDropped;
+    QMutex mMutex;
+    QWaitCondition mNotEmpty, mNotFull;
+};
+
+#endif // VIDEORECORDER_H
@@ -0,0 +1,283 @@
+//
+// Configuration
+//
+
+// Includes
+#include "workpool.h"
+#include <algorithm>
+#include <QMutexLocker>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Pool properties
+#define POOL_MIN_BACKOFF 1          // before a parked task gets queued again, in milliseconds
+#define POOL_MAX_BACKOFF 8          // in milliseconds
+
+
+//
+// Construction and destruction
+//
+
+WorkPool::WorkPool(int iThreads) : mQueued(0), mNext(0), mStolen(0), mStopping(false), mActive(0)
+{
+    mClock.start();
+    iThreads = std::max(1, iThreads);
+    for (int i = 0; i < iThreads; i++)
+        mQueues.push_back(new Queue());
+    for (int i = 0; i < iThreads; i++)
+    {
+        mWorkers.push_back(new Worker(this, i));
+        mWorkers.back()->start();
+    }
+}
+
+WorkPool::~WorkPool()
+{
+    stop();
+    for (size_t i = 0; i < mWorkers.size(); i++)
+    {
+        delete mWorkers[i];
+        delete mQueues[i];
+    }
+}
+
+
+//
+// Tasks
+//
+
+// Queue a task, which the pool doesn't take ownership of
+void WorkPool::submit(Task* iTask)
+{
+    {
+        QMutexLocker tLocker(&mMutex);
+        mActive++;
+    }
+    iTask->mAge = 0;
+    iTask->mBackoff = 0;
+    push((unsigned int) mNext.fetchAndAddRelaxed(1) % mWorkers.size(), iTask);
+}
+
+// Block until every submitted task stopped asking to run again, or until
+// the timeout (in milliseconds) expires. Returns whether they all did.
+bool WorkPool::wait(unsigned long iTimeout)
+{
+    QMutexLocker tLocker(&mMutex);
+    while (mActive > 0)
+    {
+        if (!mIdle.wait(&mMutex, iTimeout))
+            break;
+    }
+    return mActive == 0;
+}
+
+// Let the workers finish the task at hand, and drop whatever is still queued
+void WorkPool::stop()
+{
+    {
+        QMutexLocker tLocker(&mMutex);
+        if (mStopping)
+            return;
+        mStopping = true;
+        mWork.wakeAll();
+    }
+    for (size_t i = 0; i < mWorkers.size(); i++)
+        mWorkers[i]->wait();
+
+    QMutexLocker tLocker(&mMutex);
+    mParked.clear();
+    mActive = 0;
+    mIdle.wakeAll();
+}
+
+
+//
+// Statistics
+//
+
+int WorkPool::threads() const
+{
+    return mWorkers.size();
+}
+
+// Tasks waiting for a worker
+int WorkPool::queued() const
+{
+    return (int) mQueued;
+}
+
+// Tasks which a worker took from the queue of another one
+unsigned long WorkPool::stolen() const
+{
+    return (int) mStolen;
+}
+
+
+//
+// Worker thread
+//
+
+void WorkPool::Worker::run()
+{
+    mPool->work(mIndex);
+}
+
+
+//
+// Scheduling
+//
+
+void WorkPool::work(int iWorker)
+{
+    // The pool already keeps every core busy, so the parallel sections
+    // within a task would only oversubscribe them
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+
+    while (!mStopping)
+    {
+        resume();
+        Task* tTask = take(iWorker);
+        if (tTask == 0)
+        {
+            // Sleep until there's work, or until the first parked task is due
+            QMutexLocker tLocker(&mMutex);
+            if (!mStopping && (int) mQueued <= 0)
+            {
+                if (mParked.empty())
+                    mWork.wait(&mMutex);
+                else
+                {
+                    qint64 tDue = mParked[0].due;
+                    for (size_t i = 1; i < mParked.size(); i++)
+                        tDue = std::min(tDue, mParked[i].due);
+                    qint64 tDelay = tDue - mClock.elapsed();
+                    if (tDelay > 0)
+                        mWork.wait(&mMutex, tDelay);
+                }
+            }
+            continue;
+        }
+
+        Task::Result tResult = tTask->run();
+        if (mStopping || tResult == Task::DONE)
+            done();
+        else if (tResult == Task::LATER)
+            park(iWorker, tTask);
+        else
+        {
+            tTask->mBackoff = 0;
+            push(iWorker, tTask);
+        }
+    }
+}
+
+void WorkPool::push(int iWorker, Task* iTask)
+{
+    // Count the task before it shows up, so no worker goes to sleep on it
+    mQueued.ref();
+    {
+        Queue& tQueue = *mQueues[iWorker];
+        QMutexLocker tLocker(&tQueue.mutex);
+        tQueue.tasks.push_back(iTask);
+    }
+
+    QMutexLocker tLocker(&mMutex);
+    mWork.wakeOne();
+}
+
+// Take a task from the own queue, or steal one from the others
+WorkPool::Task* WorkPool::take(int iWorker)
+{
+    Task* tTask = pick(*mQueues[iWorker]);
+    if (tTask != 0)
+        return tTask;
+
+    int tWorkers = mQueues.size();
+    for (int i = 1; i < tWorkers; i++)
+    {
+        tTask = pick(*mQueues[(iWorker + i) % tWorkers]);
+        if (tTask != 0)
+        {
+            mStolen.ref();
+            return tTask;
+        }
+    }
+    return 0;
+}
+
+// Remove the first task of the highest (aged) priority from a queue, aging
+// the ones it gets picked over
+WorkPool::Task* WorkPool::pick(Queue& iQueue)
+{
+    QMutexLocker tLocker(&iQueue.mutex);
+    if (iQueue.tasks.empty())
+        return 0;
+
+    size_t tBest = 0;
+    for (size_t i = 1; i < iQueue.tasks.size(); i++)
+    {
+        const Task* tTask = iQueue.tasks[i];
+        const Task* tBestTask = iQueue.tasks[tBest];
+        if (tTask->mPriority + tTask->mAge > tBestTask->mPriority + tBestTask->mAge)
+            tBest = i;
+    }
+    for (size_t i = 0; i < tBest; i++)
+        iQueue.tasks[i]->mAge++;
+
+    Task* tTask = iQueue.tasks[tBest];
+    tTask->mAge = 0;
+    iQueue.tasks.erase(iQueue.tasks.begin() + tBest);
+    mQueued.deref();
+    return tTask;
+}
+
+// Set a task aside until its back-off expires
+void WorkPool::park(int iWorker, Task* iTask)
+{
+    iTask->mBackoff = iTask->mBackoff == 0 ? POOL_MIN_BACKOFF : std::min(2 * iTask->mBackoff, POOL_MAX_BACKOFF);
+
+    Parked tParked;
+    tParked.task = iTask;
+    tParked.worker = iWorker;
+    tParked.due = mClock.elapsed() + iTask->mBackoff;
+    // A worker which went to sleep before may have to wake up for it
+    QMutexLocker tLocker(&mMutex);
+    mParked.push_back(tParked);
+    mWork.wakeOne();
+}
+
+// Queue the parked tasks which are due again, with the worker which parked
+// them
+void WorkPool::resume()
+{
+    std::vector<Parked> tDue;
+    {
+        QMutexLocker tLocker(&mMutex);
+        if (mParked.empty())
+            return;
+        qint64 tNow = mClock.elapsed();
+        for (size_t i = 0; i < mParked.size(); )
+        {
+            if (mParked[i].due <= tNow)
+            {
+                tDue.push_back(mParked[i]);
+                mParked[i] = mParked.back();
+                mParked.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+    for (size_t i = 0; i < tDue.size(); i++)
+        push(tDue[i].worker, tDue[i].task);
+}
+
+void WorkPool::done()
+{
+    QMutexLocker tLocker(&mMutex);
+    if (--mActive == 0)
+        mIdle.wakeAll();
+}
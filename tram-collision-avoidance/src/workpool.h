@@ -0,0 +1,127 @@
+//
+// Configuration
+//
+
+// Include guard
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+// Includes
+#include <climits>
+#include <deque>
+#include <vector>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+/*
+  The WorkPool runs tasks on a fixed set of worker threads. Every worker has
+  a queue of its own, and a task which asks to run again goes back onto the
+  queue of the worker which just ran it, so it tends to stay on the same core
+  (and its data in the same cache). A worker which runs out of tasks steals
+  one from the queue of another worker, so no thread idles while there's
+  work left.
+
+  A task is only ever queued once, so it never runs on two threads at the
+  same time. Workers pick the task of the highest priority first, and tasks
+  of equal priority take turns. Every time a task gets passed over, its
+  priority goes up by one, so even the least important ones get to run.
+
+  A task which has nothing to do yet (e.g. a live stream without a new
+  frame) doesn't wait for it on a worker, but reports so and gets parked:
+  it only gets queued again after a short delay, which doubles every time
+  it comes back empty-handed, so the workers keep serving the tasks which
+  are ready.
+  */
+class WorkPool
+{
+public:
+    // Unit of work, which reports whether it wants to run again
+    class Task
+    {
+    public:
+        enum Result
+        {
+            DONE,           // finished, don't run again
+            AGAIN,          // run again as soon as possible
+            LATER           // not ready, run again after a while
+        };
+
+        Task(int iPriority = 0) : mPriority(iPriority), mAge(0), mBackoff(0) {}
+        virtual ~Task() {}
+        virtual Result run() = 0;
+        int priority() const { return mPriority; }
+
+    private:
+        friend class WorkPool;
+        int mPriority, mAge, mBackoff;
+    };
+
+    // Construction and destruction
+    WorkPool(int iThreads);
+    ~WorkPool();
+
+    // Tasks
+    void submit(Task* iTask);
+    bool wait(unsigned long iTimeout = ULONG_MAX);
+    void stop();
+
+    // Statistics
+    int threads() const;
+    int queued() const;
+    unsigned long stolen() const;
+
+private:
+    // Worker thread
+    class Worker : public QThread
+    {
+    public:
+        Worker(WorkPool* iPool, int iIndex) : mPool(iPool), mIndex(iIndex) {}
+    protected:
+        void run();
+    private:
+        WorkPool* mPool;
+        int mIndex;
+    };
+
+    // Queue of a single worker
+    struct Queue
+    {
+        QMutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    // Task waiting to be queued again
+    struct Parked
+    {
+        Task* task;
+        int worker;
+        qint64 due;                 // on the clock of the pool, in milliseconds
+    };
+
+    // Scheduling
+    void work(int iWorker);
+    void push(int iWorker, Task* iTask);
+    Task* take(int iWorker);
+    Task* pick(Queue& iQueue);
+    void park(int iWorker, Task* iTask);
+    void resume();
+    void done();
+
+    // Member data
+    std::vector<Worker*> mWorkers;
+    std::vector<Queue*> mQueues;
+    QAtomicInt mQueued, mNext, mStolen;
+    volatile bool mStopping;
+
+    // Idle workers, parked tasks, and waiting for the tasks to finish
+    QMutex mMutex;
+    QWaitCondition mWork, mIdle;
+    int mActive;
+    std::vector<Parked> mParked;
+    QElapsedTimer mClock;
+};
+
+#endif // WORKPOOL_H